@@ -0,0 +1,357 @@
+// Microbenchmarks das primitivas de desenho e das saídas do painel
+//
+// Cada caso roda BENCH_WARMUP vezes sem medir e depois o número de chamadas da
+// tabela. O resultado sai em CSV na saída padrão:
+//
+//   name,calls,ns_per_call,cycles_per_call,timer_us_per_call
+//
+// ns_per_call é o tempo gasto pela CPU que executa o benchmark: o timer do
+// RP2040 na placa, clock_gettime(CLOCK_MONOTONIC) no host. cycles_per_call
+// converte esse tempo em ciclos de clk_sys e só existe na placa. timer_us_per_call
+// vem sempre de time_us_64(); no host é o relógio simulado, ou seja, o custo de
+// barramento (I2C, WS2812) modelado pela simulação.
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "ssd1306.h"
+#include "fonts.h"
+#include "painel.h"
+#include "joystick.h"
+#include "direction.h"
+#include "ingest.h"
+#include "matrix_anim.h"
+
+#if !PICO_ON_DEVICE
+#include <time.h>
+#endif
+
+#define MATRIX_PIN 7
+#define BENCH_WARMUP 3
+#define BENCH_I2C_HZ 400000      // Frequência da tabela principal
+#define BENCH_I2C_FAST_HZ 1000000 // Casos de barramento repetidos em Fast-mode Plus
+
+typedef struct {
+    const char *name;
+    void (*fn)(uint32_t i);
+    uint32_t calls;
+} bench_case_t;
+
+static inline uint64_t bench_now_ns(void) {
+#if PICO_ON_DEVICE
+    return time_us_64() * 1000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static void bench_fill(uint32_t i) {
+    ssd1306_fill(&display, i & 1);
+}
+
+static void bench_rect(uint32_t i) {
+    ssd1306_rect(&display, 3, 3, 122, 58, i & 1, false);
+}
+
+static void bench_rect_filled(uint32_t i) {
+    ssd1306_rect(&display, 3, 3, 122, 58, i & 1, true);
+}
+
+static void bench_draw_string(uint32_t i) {
+    ssd1306_draw_string(&display, (i & 1) ? "Gas 5L" : "Gas 2L", 10, 50);
+}
+
+static void bench_draw_string_aligned(uint32_t i) {
+    ssd1306_draw_string(&display, (i & 1) ? "Gas 5L" : "Gas 2L", 10, 48);
+}
+
+// Fonte proporcional: largura de cada glifo pela tabela widths
+static void bench_draw_text_prop(uint32_t i) {
+    ssd1306_draw_text(&display, &font_8x8_prop, (i & 1) ? "Gas 5L" : "Gas 2L", 10, 48, SSD1306_GLYPH_OPAQUE);
+}
+
+// Dígitos grandes do velocímetro: três páginas por glifo, descompactados a cada desenho
+static void bench_draw_text_digitos(uint32_t i) {
+    ssd1306_draw_text(&display, &font_digitos, (i & 1) ? "100" : " 42", 40, 16, SSD1306_GLYPH_OPAQUE);
+}
+
+// Quadro inteiro: cor alternada para que nenhum byte coincida com o já enviado
+static void bench_send_data_full(uint32_t i) {
+    ssd1306_fill(&display, i & 1);
+    ssd1306_send_data(&display);
+}
+
+// Um byte alterado: mede o custo fixo de janela e transação por envio
+static void bench_send_data_small(uint32_t i) {
+    ssd1306_pixel(&display, 64, 32, i & 1);
+    ssd1306_send_data(&display);
+}
+
+// Sequência de inicialização do controlador (sem o quadro completo que ela força)
+static void bench_config(uint32_t i) {
+    (void)i;
+    ssd1306_config(&display);
+}
+
+// Nada a enviar: mede só a varredura das regiões sujas
+static void bench_send_data_clean(uint32_t i) {
+    (void)i;
+    ssd1306_send_data(&display);
+}
+
+static void bench_update_leds(uint32_t i) {
+    (void)i;
+    update_leds();
+}
+
+// Seta diferente a cada chamada: espera o quadro anterior travar e envia
+static void bench_seta_change(uint32_t i) {
+    matrix_wait(&matriz);
+    matrix_show_frame(&matriz, setas[i % DIRECAO_COUNT]);
+}
+
+// Mesma seta: só a verificação de mudança
+static void bench_seta_same(uint32_t i) {
+    (void)i;
+    matrix_show_frame(&matriz, setas[DIRECAO_CENTRO]);
+}
+
+// Caminho de main() com o joystick parado: classificação e verificação de mudança
+static void bench_atualizar_matriz(uint32_t i) {
+    (void)i;
+    int16_t x = 0, y = 0;
+    atualizar_matriz(&x, &y);
+}
+
+// Um quadro de transição entre duas setas por chamada, esperando o anterior travar
+static matrix_anim_t bench_anim;
+
+static void bench_anim_step(uint32_t i, matrix_anim_mode_t mode) {
+    if (!matrix_anim_active(&bench_anim))
+        matrix_anim_start(&bench_anim, setas[(i & 1) ? DIRECAO_DIREITA : DIRECAO_ESQUERDA], mode, (i & 1) ? 1 : -1, 0);
+    matrix_wait(&matriz);
+    matrix_anim_tick(&bench_anim);
+}
+
+static void bench_anim_fade(uint32_t i) {
+    bench_anim_step(i, MATRIX_ANIM_FADE);
+}
+
+static void bench_anim_slide(uint32_t i) {
+    bench_anim_step(i, MATRIX_ANIM_SLIDE);
+}
+
+// Classificação com histerese de pontos espalhados pelo curso
+static direction_classifier_t bench_direction;
+
+static void bench_direction_classify(uint32_t i) {
+    uint32_t h = i * 2654435761u;
+    volatile direction_t d = direction_classify(&bench_direction, (int16_t)((h & 2047) - 1024), (int16_t)((h >> 16 & 2047) - 1024));
+    (void)d;
+}
+
+// Varredura exaustiva da grade de 12 bits: cada chamada classifica uma linha
+// de Y (4096 pontos de X), sem histerese entre pontos, convertendo as contagens
+// como joystick_read com a calibração padrão. O total por setor sai num
+// comentário depois da tabela
+static uint32_t bench_sweep_count[DIRECTION_MAX_SECTORS + 1];
+
+static int16_t bench_scale(uint32_t raw) {
+    return raw < 2048 ? ((int32_t)raw - 2048) * JOYSTICK_FULL_SCALE / 2048
+                      : ((int32_t)raw - 2048) * JOYSTICK_FULL_SCALE / 2047;
+}
+
+static void bench_direction_sweep(uint32_t i) {
+    if (i == 0) // Recomeça depois do aquecimento
+        memset(bench_sweep_count, 0, sizeof(bench_sweep_count));
+    int16_t y = bench_scale(i & 4095);
+    for (uint32_t raw_x = 0; raw_x < 4096; ++raw_x) {
+        direction_reset(&bench_direction);
+        direction_t d = direction_classify(&bench_direction, bench_scale(raw_x), y);
+        ++bench_sweep_count[d.sector == DIRECTION_CENTER ? DIRECTION_MAX_SECTORS : d.sector];
+    }
+}
+
+// Análise dos quadros do veículo: cada chamada entrega 64 bytes (quatro blocos
+// de DMA) de um fluxo de 256 quadros, um deles com o CRC errado, e analisa o
+// que chegou. Os totais saem num comentário depois da tabela
+#define BENCH_INGEST_CHUNK 64
+#define BENCH_INGEST_FRAME (INGEST_HEADER_BYTES + INGEST_PAYLOAD_MIN + INGEST_CRC_BYTES)
+static uint8_t bench_ingest_stream[256 * BENCH_INGEST_FRAME];
+static uint8_t bench_ingest_ring[256];
+static ingest_parser_t bench_ingest;
+static uint32_t bench_ingest_head, bench_ingest_pos;
+
+static void bench_ingest_init(void) {
+    uint len = 0;
+    for (uint32_t k = 0; k < 256; ++k)
+        len += ingest_encode(bench_ingest_stream + len, k, k * 4, 900 - k, k & INGEST_FLAG_MM);
+    bench_ingest_stream[100 * BENCH_INGEST_FRAME + 5] ^= 0x01;
+}
+
+static void bench_ingest_parse(uint32_t i) {
+    if (i == 0) { // Recomeça depois do aquecimento
+        ingest_parser_init(&bench_ingest, bench_ingest_ring, sizeof(bench_ingest_ring),
+                           sizeof(bench_ingest_ring) - 2 * INGEST_BLOCK_BYTES);
+        bench_ingest_head = bench_ingest_pos = 0;
+    }
+    for (uint32_t b = 0; b < BENCH_INGEST_CHUNK; ++b) {
+        bench_ingest_ring[bench_ingest_head++ % sizeof(bench_ingest_ring)] = bench_ingest_stream[bench_ingest_pos++];
+        if (bench_ingest_pos == sizeof(bench_ingest_stream))
+            bench_ingest_pos = 0;
+    }
+    ingest_parse(&bench_ingest, bench_ingest_head, i);
+}
+
+static void bench_joystick_read(uint32_t i) {
+    (void)i;
+    volatile joystick_state_t s = joystick_read();
+    (void)s;
+}
+
+// Quadro do painel como montado no núcleo 1, só o desenho: a velocidade muda a cada chamada
+static void bench_dashboard_draw(uint32_t i) {
+    painel_estado_t estado = {.contador = i % 101};
+    desenhar_painel(true, &estado);
+}
+
+// Estado repetido: nenhum widget muda, nada é desenhado
+static void bench_dashboard_same(uint32_t i) {
+    (void)i;
+    painel_estado_t estado = {.contador = 42};
+    desenhar_painel(true, &estado);
+}
+
+// Quadro do painel desenhado e enviado, esperando o fim da transmissão
+static void bench_dashboard_frame(uint32_t i) {
+    painel_estado_t estado = {.contador = i % 101};
+    desenhar_painel(true, &estado);
+    ssd1306_send_data(&display);
+}
+
+// Só a velocidade muda: desenho e envio da região direto do buffer, como no núcleo 1
+static void bench_dashboard_region(uint32_t i) {
+    painel_estado_t estado = {.contador = i % 101};
+    enviar_painel(desenhar_painel(true, &estado));
+    ssd1306_flush_wait(&display);
+}
+
+// Todos os displays com o quadro inteiro: com painéis nos dois barramentos o
+// tempo é o do barramento mais carregado, não a soma
+static void bench_group_full(uint32_t i) {
+    for (uint p = 0; p < paineis.n_panels; ++p) {
+        ssd1306_fill(paineis.panels[p], i & 1);
+    }
+    ssd1306_group_flush(&paineis);
+    ssd1306_group_wait(&paineis);
+}
+
+static const bench_case_t bench_cases[] = {
+    {"ssd1306_fill", bench_fill, 2000},
+    {"ssd1306_rect", bench_rect, 2000},
+    {"ssd1306_rect_filled", bench_rect_filled, 2000},
+    {"ssd1306_draw_string", bench_draw_string, 2000},
+    {"ssd1306_draw_string_aligned", bench_draw_string_aligned, 2000},
+    {"ssd1306_draw_text_prop", bench_draw_text_prop, 2000},
+    {"ssd1306_draw_text_digitos", bench_draw_text_digitos, 2000},
+    {"ssd1306_config", bench_config, 50},
+    {"ssd1306_send_data_full", bench_send_data_full, 50},
+    {"ssd1306_send_data_small", bench_send_data_small, 500},
+    {"ssd1306_send_data_clean", bench_send_data_clean, 2000},
+    {"update_leds", bench_update_leds, 200},
+    {"seta_change", bench_seta_change, 200},
+    {"seta_same", bench_seta_same, 2000},
+    {"atualizar_matriz", bench_atualizar_matriz, 200},
+    {"matrix_anim_fade", bench_anim_fade, 200},
+    {"matrix_anim_slide", bench_anim_slide, 200},
+    {"direction_classify", bench_direction_classify, 2000},
+    {"direction_sweep", bench_direction_sweep, 4096},
+    {"ingest_parse", bench_ingest_parse, 2000},
+    {"joystick_read", bench_joystick_read, 2000},
+    {"dashboard_draw", bench_dashboard_draw, 1000},
+    {"dashboard_same", bench_dashboard_same, 2000},
+    {"dashboard_frame", bench_dashboard_frame, 100},
+    {"dashboard_region", bench_dashboard_region, 100},
+    {"group_full", bench_group_full, 50},
+};
+
+// Casos limitados pelo barramento, repetidos com o I2C em BENCH_I2C_FAST_HZ
+static const bench_case_t bench_bus_cases[] = {
+    {"ssd1306_config", bench_config, 50},
+    {"ssd1306_send_data_full", bench_send_data_full, 50},
+    {"ssd1306_send_data_small", bench_send_data_small, 500},
+    {"dashboard_frame", bench_dashboard_frame, 100},
+    {"dashboard_region", bench_dashboard_region, 100},
+    {"group_full", bench_group_full, 50},
+};
+
+static void bench_run(const bench_case_t *b, const char *suffix) {
+    for (uint32_t i = 0; i < BENCH_WARMUP; ++i)
+        b->fn(i);
+    // Cada caso começa com o envio anterior concluído
+    ssd1306_flush_wait(&display);
+
+    uint64_t t_us = time_us_64();
+    uint64_t t_ns = bench_now_ns();
+    for (uint32_t i = 0; i < b->calls; ++i)
+        b->fn(i);
+    uint64_t ns = bench_now_ns() - t_ns;
+    uint64_t timer_us = time_us_64() - t_us;
+
+    double ns_per_call = (double)ns / b->calls;
+#if PICO_ON_DEVICE
+    printf("%s%s,%lu,%.1f,%.0f,%.3f\n", b->name, suffix, (unsigned long)b->calls, ns_per_call,
+           ns_per_call * clock_get_hz(clk_sys) / 1e9, (double)timer_us / b->calls);
+#else
+    printf("%s%s,%lu,%.1f,,%.3f\n", b->name, suffix, (unsigned long)b->calls, ns_per_call,
+           (double)timer_us / b->calls);
+#endif
+}
+
+int main() {
+    stdio_init_all();
+#if PICO_ON_DEVICE
+    sleep_ms(2000); // Tempo para o terminal USB conectar
+#endif
+    init_matrix(MATRIX_PIN);
+    init_leds();
+    init_display();
+    joystick_init(NULL);
+    matrix_anim_init(&bench_anim, &matriz, 160000, 50);
+    direction_init(&bench_direction, &(direction_config_t){.deadzone = 200, .radial_hysteresis = 50,
+                                                           .angular_hysteresis = 512, .sectors = 8});
+    bench_ingest_init();
+
+    printf("# platform=%s clk_sys_hz=%lu\n", PICO_ON_DEVICE ? "rp2040" : "host",
+           (unsigned long)clock_get_hz(clk_sys));
+    printf("name,calls,ns_per_call,cycles_per_call,timer_us_per_call\n");
+    ssd1306_flush_wait(&display);
+    i2c_bus_set_baudrate(display.i2c_port, BENCH_I2C_HZ);
+    for (unsigned i = 0; i < count_of(bench_cases); ++i)
+        bench_run(&bench_cases[i], "");
+    printf("# direction_sweep centro=%lu", (unsigned long)bench_sweep_count[DIRECTION_MAX_SECTORS]);
+    for (unsigned s = 0; s < 8; ++s)
+        printf(" s%u=%lu", s, (unsigned long)bench_sweep_count[s]);
+    printf("\n");
+    printf("# ingest_parse bytes=%lu quadros=%lu crc=%lu ignorados=%lu perdidos=%lu\n",
+           (unsigned long)bench_ingest_head, (unsigned long)bench_ingest.stats.frames,
+           (unsigned long)bench_ingest.stats.crc_errors, (unsigned long)bench_ingest.stats.skipped,
+           (unsigned long)bench_ingest.stats.lost);
+    if (ssd1306_probe_baudrate(&display, BENCH_I2C_FAST_HZ, BENCH_I2C_HZ)) {
+        for (unsigned i = 0; i < count_of(bench_bus_cases); ++i)
+            bench_run(&bench_bus_cases[i], "@1mhz");
+    } else {
+        printf("# painel não respondeu a %u Hz\n", BENCH_I2C_FAST_HZ);
+    }
+    printf("# end\n");
+    fflush(stdout);
+
+#if PICO_ON_DEVICE
+    while (true)
+        tight_loop_contents();
+#endif
+    return 0;
+}
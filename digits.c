@@ -0,0 +1,63 @@
+#include <string.h>
+#include "digits.h"
+
+static const char digits_chars[DIGITS_GLYPHS] = " -0123456789";
+
+// Posição do caractere na tabela de glifos prontos; os demais usam o espaço
+static inline uint8_t digits_slot(char c) {
+  if (c >= '0' && c <= '9')
+    return 2 + (c - '0');
+  return c == '-' ? 1 : 0;
+}
+
+// Prepara os glifos de font, que precisa ter passo fixo. Fontes sem
+// compactação são lidas direto da flash e dispensam storage; nas compactadas
+// os glifos são descompactados uma vez em storage, com pelo menos
+// DIGITS_STORAGE_BYTES(advance x páginas) bytes. Retorna false se não couber
+bool digits_font_init(digits_font_t *d, const font_t *font, void *storage, uint32_t size) {
+  uint32_t cell = font->advance * font->pages;
+  if (font->advance == 0 || (font->rle && size < DIGITS_STORAGE_BYTES(cell)))
+    return false;
+  d->font = font;
+  d->width = font->advance;
+  for (uint i = 0; i < DIGITS_GLYPHS; ++i) {
+    uint8_t g = font_find(font, digits_chars[i]);
+    if (font->rle) {
+      uint8_t *dst = (uint8_t *)storage + i * cell;
+      uint8_t buf[FONT_MAX_GLYPH_BYTES];
+      memcpy(dst, font_glyph(font, g, buf), cell);
+      d->cols[i] = dst;
+    } else {
+      d->cols[i] = font_glyph(font, g, NULL);
+    }
+  }
+  return true;
+}
+
+void digits_cache_init(digits_cache_t *c, const digits_font_t *font, uint8_t cells) {
+  c->font = font;
+  c->cells = cells < DIGITS_MAX_CELLS ? cells : DIGITS_MAX_CELLS;
+  digits_cache_invalidate(c);
+}
+
+// O buffer foi limpo ou sobrescrito por fora: o próximo desenho reescreve todas as células
+void digits_cache_invalidate(digits_cache_t *c) {
+  memset(c->shown, 0, sizeof(c->shown));
+}
+
+// Desenha text nas células a partir de (x, y), reescrevendo só as que mudaram;
+// caracteres além das células são ignorados e as que sobram ficam em branco.
+// Retorna a coluna depois da última célula
+uint8_t digits_cache_draw(digits_cache_t *c, ssd1306_t *ssd, const char *text, uint8_t x, uint8_t y, uint8_t mode) {
+  const digits_font_t *d = c->font;
+  for (uint8_t i = 0; i < c->cells; ++i, x += d->width) {
+    char ch = *text ? *text++ : ' ';
+    if (c->shown[i] == ch)
+      continue;
+    const uint8_t *cols = d->cols[digits_slot(ch)];
+    for (uint8_t p = 0; p < d->font->pages && y + 8 * p < ssd1306_height(ssd); ++p)
+      ssd1306_blit(ssd, cols + p * d->width, d->width, x, y + 8 * p, mode);
+    c->shown[i] = ch;
+  }
+  return x;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ssd1306.h"
+
+// Dígitos pré-rasterizados para números que mudam a cada quadro. Os glifos de
+// ' ', '-' e '0' a '9' de uma fonte de passo fixo ficam prontos para cópia
+// (descompactados, se a fonte for RLE), e cada número desenhado guarda o que
+// já está em cada célula: só as células cujo caractere mudou são reescritas
+// no buffer e marcadas como alteradas.
+
+#define DIGITS_GLYPHS 12    // ' ', '-', '0'..'9'
+#define DIGITS_MAX_CELLS 10 // Dígitos de um uint32_t
+
+// Armazenamento para os glifos de uma fonte compactada (ex.: FONT_DIGITOS_CELL_BYTES)
+#define DIGITS_STORAGE_BYTES(cell_bytes) (DIGITS_GLYPHS * (cell_bytes))
+
+typedef struct {
+  const font_t *font;
+  uint8_t width;                       // Colunas por célula (advance da fonte)
+  const uint8_t *cols[DIGITS_GLYPHS];  // Colunas de cada glifo, página a página
+} digits_font_t;
+
+typedef struct {
+  const digits_font_t *font;
+  uint8_t cells;                  // Células do número
+  char shown[DIGITS_MAX_CELLS];   // Caractere em cada célula no buffer; '\0' se desconhecido
+} digits_cache_t;
+
+bool digits_font_init(digits_font_t *d, const font_t *font, void *storage, uint32_t size);
+void digits_cache_init(digits_cache_t *c, const digits_font_t *font, uint8_t cells);
+void digits_cache_invalidate(digits_cache_t *c);
+uint8_t digits_cache_draw(digits_cache_t *c, ssd1306_t *ssd, const char *text, uint8_t x, uint8_t y, uint8_t mode);
+
+// Falso até o primeiro desenho e depois de digits_cache_invalidate
+static inline bool digits_cache_valid(const digits_cache_t *c) {
+  return c->shown[0] != '\0';
+}
@@ -0,0 +1,83 @@
+#include "direction.h"
+
+// atan(i / 64) em 1/65536 de volta, de 0 a 1/8 de volta
+static const uint16_t direction_atan[65] = {
+      0,   163,   326,   489,   651,   813,   975,  1136,  1297,  1457,  1617,  1775,
+   1933,  2090,  2246,  2401,  2555,  2708,  2860,  3010,  3159,  3307,  3453,  3599,
+   3742,  3884,  4025,  4164,  4302,  4438,  4572,  4705,  4836,  4966,  5094,  5220,
+   5344,  5467,  5589,  5708,  5826,  5943,  6058,  6171,  6282,  6392,  6500,  6607,
+   6712,  6815,  6917,  7018,  7117,  7214,  7310,  7405,  7498,  7589,  7679,  7768,
+   7856,  7942,  8026,  8110,  8192,
+};
+
+// sqrt(1 + (i / 64)^2) em Q14: módulo = maior eixo x este fator
+static const uint16_t direction_sec[65] = {
+  16384, 16386, 16392, 16402, 16416, 16434, 16456, 16482, 16512, 16545, 16583, 16624,
+  16670, 16719, 16771, 16828, 16888, 16952, 17020, 17091, 17165, 17243, 17325, 17410,
+  17498, 17590, 17684, 17782, 17883, 17988, 18095, 18205, 18318, 18434, 18552, 18674,
+  18798, 18925, 19054, 19186, 19321, 19458, 19597, 19739, 19882, 20029, 20177, 20327,
+  20480, 20635, 20791, 20950, 21110, 21273, 21437, 21603, 21771, 21940, 22111, 22284,
+  22458, 22634, 22811, 22990, 23170,
+};
+
+void direction_init(direction_classifier_t *c, const direction_config_t *config) {
+  c->config = *config;
+  uint8_t shift = 16;
+  for (uint n = config->sectors; n > 1 && shift > 0; n >>= 1)
+    --shift;
+  c->shift = shift;
+  direction_reset(c);
+}
+
+// Esquece o setor anterior: a próxima leitura é classificada sem histerese angular
+void direction_reset(direction_classifier_t *c) {
+  c->sector = DIRECTION_CENTER;
+}
+
+// Ângulo e módulo de (x, y) sem ponto flutuante. A razão entre o menor e o
+// maior eixo (Q12, uma divisão) indexa as tabelas do primeiro octante, com
+// interpolação linear; os sinais e a troca dos eixos levam ao octante certo
+void direction_polar(int16_t x, int16_t y, uint16_t *angle, uint16_t *magnitude) {
+  uint32_t ax = x < 0 ? -(int32_t)x : x, ay = y < 0 ? -(int32_t)y : y;
+  uint32_t hi = ax > ay ? ax : ay, lo = ax > ay ? ay : ax;
+  uint32_t r = hi ? (lo << 12) / hi : 0;
+  uint32_t i = r >> 6, frac = r & 63;
+  uint32_t next = i < 64 ? i + 1 : 64;
+  uint16_t a = direction_atan[i] + (((direction_atan[next] - direction_atan[i]) * frac) >> 6);
+  uint32_t k = direction_sec[i] + (((direction_sec[next] - direction_sec[i]) * frac) >> 6);
+
+  if (ay > ax)
+    a = DIRECTION_TURN / 4 - a;
+  if (x < 0)
+    a = DIRECTION_TURN / 2 - a;
+  if (y < 0)
+    a = -a;
+  *angle = a;
+  *magnitude = (hi * k) >> 14;
+}
+
+// Setor da leitura (x, y). Do centro só se sai com deadzone + radial_hysteresis,
+// e o setor atual só muda quando o ângulo passa angular_hysteresis da fronteira
+direction_t direction_classify(direction_classifier_t *c, int16_t x, int16_t y) {
+  direction_t d;
+  direction_polar(x, y, &d.angle, &d.magnitude);
+
+  uint32_t threshold = c->config.deadzone;
+  if (c->sector == DIRECTION_CENTER)
+    threshold += c->config.radial_hysteresis;
+  if (d.magnitude < threshold) {
+    d.sector = DIRECTION_CENTER;
+  } else {
+    uint16_t half = (1u << c->shift) / 2;
+    d.sector = (uint16_t)(d.angle + half) >> c->shift;
+    if (c->sector != DIRECTION_CENTER && d.sector != c->sector) {
+      // Distância (com sinal) ao meio do setor atual
+      int16_t off = (int16_t)(d.angle - ((uint32_t)c->sector << c->shift));
+      uint32_t dist = off < 0 ? -(int32_t)off : off;
+      if (dist <= half + c->config.angular_hysteresis)
+        d.sector = c->sector;
+    }
+  }
+  c->sector = d.sector;
+  return d;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+// Classificação da posição calibrada do joystick em setores, em tempo
+// constante: atan2 e módulo em ponto fixo por tabela, zona morta no centro e
+// histerese em todas as fronteiras, para que a leitura não oscile entre dois
+// setores vizinhos.
+
+#define DIRECTION_CENTER 0xFF    // Setor dentro da zona morta
+#define DIRECTION_TURN 65536u    // Ângulos em 1/65536 de volta
+#define DIRECTION_MAX_SECTORS 16
+
+typedef struct {
+  uint16_t deadzone;           // Raio do centro, nas unidades de joystick_state_t
+  uint16_t radial_hysteresis;  // Sair do centro exige deadzone + radial_hysteresis
+  uint16_t angular_hysteresis; // Além da fronteira, em 1/65536 de volta, para trocar de setor
+  uint8_t sectors;             // 8 ou 16 (potência de 2 até DIRECTION_MAX_SECTORS)
+} direction_config_t;
+
+typedef struct {
+  uint8_t sector;     // 0 centrado em +x, crescendo no sentido anti-horário; DIRECTION_CENTER no centro
+  uint16_t angle;     // atan2(y, x) em 1/65536 de volta
+  uint16_t magnitude; // Deflexão: JOYSTICK_FULL_SCALE no fim de curso de um eixo
+} direction_t;
+
+typedef struct {
+  direction_config_t config;
+  uint8_t shift;  // log2 da largura do setor em 1/65536 de volta
+  uint8_t sector; // Último setor, base da histerese
+} direction_classifier_t;
+
+void direction_init(direction_classifier_t *c, const direction_config_t *config);
+void direction_reset(direction_classifier_t *c);
+direction_t direction_classify(direction_classifier_t *c, int16_t x, int16_t y);
+void direction_polar(int16_t x, int16_t y, uint16_t *angle, uint16_t *magnitude);
@@ -0,0 +1,48 @@
+#include "font.h"
+
+// Fonte sem tabela densa: busca binária na lista ordenada de códigos
+uint8_t font_find_sparse(const font_t *f, uint8_t code) {
+  unsigned lo = 0, hi = f->count;
+  while (lo < hi) {
+    unsigned mid = (lo + hi) / 2;
+    if (f->codes[mid] < code)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < f->count && f->codes[lo] == code ? lo : f->fallback;
+}
+
+// Colunas do glifo, página a página. Sem compactação aponta direto para a
+// tabela na flash; com ela descompacta em buf e retorna buf
+const uint8_t *font_glyph(const font_t *f, uint8_t glyph, uint8_t buf[FONT_MAX_GLYPH_BYTES]) {
+  const uint8_t *src = &f->bitmaps[f->offsets[glyph]];
+  if (!f->rle)
+    return src;
+  const uint8_t *end = &f->bitmaps[f->offsets[glyph + 1]];
+  uint8_t *dst = buf;
+  while (src < end) {
+    uint8_t n = *src++;
+    if (n < 128) {
+      for (unsigned i = 0; i <= n; ++i)
+        *dst++ = *src++;
+    } else {
+      uint8_t v = *src++;
+      for (unsigned i = 0; i < n - 126u; ++i)
+        *dst++ = v;
+    }
+  }
+  return buf;
+}
+
+// Largura do texto em colunas, sem o espaçamento depois do último glifo
+uint16_t font_text_width(const font_t *f, const char *str) {
+  uint16_t w = 0;
+  uint8_t last = 0;
+  while (*str) {
+    uint8_t g = font_find(f, *str++);
+    last = font_advance(f, g) - f->widths[g];
+    w += font_advance(f, g);
+  }
+  return w - last;
+}
@@ -1,76 +1,47 @@
+#pragma once
 
-// Fontes para A-Z e 0-9. Os caracteres tem 8x8 pixels
+#include <stdbool.h>
+#include <stdint.h>
 
+// Fontes geradas na compilação por fonts/fontgen.py a partir de fonts/*.txt;
+// as tabelas (fonts.c, fonts.h) são const e ficam na flash. Cada glifo já vem
+// no formato das páginas do SSD1306: para cada página de 8 linhas, um byte
+// por coluna com o bit 0 na linha de cima.
 
-static uint8_t font[] = {
-    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Nothing
-    0x3e, 0x41, 0x41, 0x49, 0x41, 0x41, 0x3e, 0x00, // 0
-    0x00, 0x00, 0x42, 0x7f, 0x40, 0x00, 0x00, 0x00, // 1
-    0x30, 0x49, 0x49, 0x49, 0x49, 0x46, 0x00, 0x00, // 2
-    0x49, 0x49, 0x49, 0x49, 0x49, 0x49, 0x36, 0x00, // 3
-    0x3f, 0x20, 0x20, 0x78, 0x20, 0x20, 0x00, 0x00, // 4
-    0x4f, 0x49, 0x49, 0x49, 0x49, 0x30, 0x00, 0x00, // 5
-    0x3f, 0x48, 0x48, 0x48, 0x48, 0x48, 0x30, 0x00, // 6 
-    0x01, 0x01, 0x01, 0x61, 0x31, 0x0d, 0x03, 0x00, // 7
-    0x36, 0x49, 0x49, 0x49, 0x49, 0x49, 0x36, 0x00, // 8
-    0x06, 0x09, 0x09, 0x09, 0x09, 0x09, 0x7f, 0x00, // 9
-    0x20, 0x54, 0x54, 0x54, 0x54, 0x78, 0x40, 0x00, // a
-    0x7F, 0x48, 0x48, 0x48, 0x48, 0x30, 0x00, 0x00, // b
-    0x38, 0x44, 0x44, 0x44, 0x44, 0x28, 0x00, 0x00, // c
-    0x30, 0x48, 0x48, 0x48, 0x48, 0x7F, 0x00, 0x00, // d
-    0x38, 0x54, 0x54, 0x54, 0x54, 0x18, 0x00, 0x00, // e
-    0x08, 0x7E, 0x09, 0x09, 0x01, 0x02, 0x00, 0x00, // f
-    0x48, 0x54, 0x54, 0x54, 0x54, 0x3C, 0x00, 0x00, // g
-    0x7F, 0x08, 0x08, 0x08, 0x08, 0x70, 0x00, 0x00, // h
-    0x00, 0x00, 0x48, 0x7D, 0x40, 0x00, 0x00, 0x00, // i
-    0x20, 0x40, 0x48, 0x3D, 0x00, 0x00, 0x00, 0x00, // j
-    0x7F, 0x10, 0x28, 0x28, 0x44, 0x00, 0x00, 0x00, // k
-    0x00, 0x41, 0x7F, 0x40, 0x00, 0x00, 0x00, 0x00, // l
-    0x7C, 0x04, 0x18, 0x04, 0x78, 0x00, 0x00, 0x00, // m
-    0x7C, 0x08, 0x04, 0x04, 0x78, 0x00, 0x00, 0x00, // n
-    0x38, 0x44, 0x44, 0x44, 0x44, 0x38, 0x00, 0x00, // o
-    0x7C, 0x24, 0x24, 0x24, 0x24, 0x18, 0x00, 0x00, // p
-    0x18, 0x24, 0x24, 0x24, 0x24, 0x7C, 0x00, 0x00, // q
-    0x7C, 0x08, 0x04, 0x04, 0x08, 0x10, 0x00, 0x00, // r
-    0x48, 0x54, 0x54, 0x54, 0x54, 0x20, 0x00, 0x00, // s
-    0x04, 0x3E, 0x44, 0x40, 0x20, 0x00, 0x00, 0x00, // t
-    0x3C, 0x40, 0x40, 0x40, 0x40, 0x7C, 0x00, 0x00, // u
-    0x0C, 0x30, 0x40, 0x30, 0x0C, 0x00, 0x00, 0x00, // v
-    0x3C, 0x60, 0x30, 0x60, 0x3C, 0x00, 0x00, 0x00, // w
-    0x44, 0x28, 0x10, 0x28, 0x44, 0x00, 0x00, 0x00, // x
-    0x4C, 0x50, 0x50, 0x50, 0x3C, 0x00, 0x00, 0x00, // y
-    0x44, 0x64, 0x54, 0x4C, 0x44, 0x00, 0x00, 0x00, // z
-    0x78, 0x14, 0x12, 0x11, 0x12, 0x14, 0x78, 0x00, //A
-    0x7f, 0x49, 0x49, 0x49, 0x49, 0x49, 0x7f, 0x00, //B
-    0x7e, 0x41, 0x41, 0x41, 0x41, 0x41, 0x41, 0x00, //C
-    0x7f, 0x41, 0x41, 0x41, 0x41, 0x41, 0x7e, 0x00, //D
-    0x7f, 0x49, 0x49, 0x49, 0x49, 0x49, 0x49, 0x00, //E
-    0x7f, 0x09, 0x09, 0x09, 0x09, 0x01, 0x01, 0x00, //F
-    0x7f, 0x41, 0x41, 0x41, 0x51, 0x51, 0x73, 0x00, //G
-    0x7f, 0x08, 0x08, 0x08, 0x08, 0x08, 0x7f, 0x00, //H
-    0x00, 0x00, 0x00, 0x7f, 0x00, 0x00, 0x00, 0x00, //I
-    0x21, 0x41, 0x41, 0x3f, 0x01, 0x01, 0x01, 0x00, //J
-    0x00, 0x7f, 0x08, 0x08, 0x14, 0x22, 0x41, 0x00, //K
-    0x7f, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, //L
-    0x7f, 0x02, 0x04, 0x08, 0x04, 0x02, 0x7f, 0x00, //M
-    0x7f, 0x02, 0x04, 0x08, 0x10, 0x20, 0x7f, 0x00, //N
-    0x3e, 0x41, 0x41, 0x41, 0x41, 0x41, 0x3e, 0x00, //O
-    0x7f, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e, 0x00, //P
-    0x3e, 0x41, 0x41, 0x49, 0x51, 0x61, 0x7e, 0x00, //Q
-    0x7f, 0x11, 0x11, 0x11, 0x31, 0x51, 0x0e, 0x00, //R
-    0x46, 0x49, 0x49, 0x49, 0x49, 0x30, 0x00, 0x00, //S
-    0x01, 0x01, 0x01, 0x7f, 0x01, 0x01, 0x01, 0x00, //T
-    0x3f, 0x40, 0x40, 0x40, 0x40, 0x40, 0x3f, 0x00, //U
-    0x0f, 0x10, 0x20, 0x40, 0x20, 0x10, 0x0f, 0x00, //V
-    0x7f, 0x20, 0x10, 0x08, 0x10, 0x20, 0x7f, 0x00, //W
-    0x00, 0x41, 0x22, 0x14, 0x14, 0x22, 0x41, 0x00, //X
-    0x01, 0x02, 0x04, 0x78, 0x04, 0x02, 0x01, 0x00, //Y
-    0x41, 0x61, 0x59, 0x45, 0x43, 0x41, 0x00, 0x00, //Z
-    0x00, 0x00, 0x5F, 0x5F, 0x00, 0x00, 0x00, 0x00, // !
-    0x00, 0x06, 0x06, 0x00, 0x06, 0x06, 0x00, 0x00, // "
-    0x14, 0x7F, 0x14, 0x7F, 0x14, 0x00, 0x00, 0x00, // #
-    0x24, 0x2E, 0x7F, 0x2E, 0x12, 0x00, 0x00, 0x00, // $
-    0x22, 0x14, 0x08, 0x14, 0x22, 0x00, 0x00, 0x00, // %
-    0x36, 0x49, 0x55, 0x22, 0x50, 0x00, 0x00, 0x00  // &
-    };
-    
\ No newline at end of file
+#define FONT_MAX_GLYPH_BYTES 256 // Maior glifo descompactado (colunas x páginas)
+#define FONT_NO_GLYPH 0xFF       // Código sem desenho em map
+
+typedef struct {
+  uint8_t height;           // Linhas do glifo
+  uint8_t pages;            // Páginas de 8 linhas ocupadas por glifo
+  uint8_t advance;          // Passo fixo; 0 numa fonte proporcional
+  uint8_t spacing;          // Colunas vazias entre glifos proporcionais
+  uint8_t n_glyphs;
+  uint8_t fallback;         // Glifo usado para os códigos sem desenho
+  bool rle;                 // Glifos compactados (PackBits); font_glyph descompacta
+  uint8_t first, count;     // Com map: faixa de códigos first..first+count-1
+  const uint8_t *map;       // Glifo por código (FONT_NO_GLYPH sem desenho), ou NULL
+  const uint8_t *codes;     // Sem map: os count códigos em ordem, glifo = posição
+  const uint8_t *widths;    // Colunas de cada glifo
+  const uint16_t *offsets;  // Início de cada glifo em bitmaps (n_glyphs + 1)
+  const uint8_t *bitmaps;
+} font_t;
+
+uint8_t font_find_sparse(const font_t *f, uint8_t code);
+const uint8_t *font_glyph(const font_t *f, uint8_t glyph, uint8_t buf[FONT_MAX_GLYPH_BYTES]);
+uint16_t font_text_width(const font_t *f, const char *str);
+
+// Glifo de um caractere: acesso direto pela tabela densa, ou busca binária
+// na lista de códigos
+static inline uint8_t font_find(const font_t *f, char c) {
+  uint8_t code = (uint8_t)c;
+  if (!f->map)
+    return font_find_sparse(f, code);
+  uint8_t i = code - f->first;
+  return i < f->count && f->map[i] != FONT_NO_GLYPH ? f->map[i] : f->fallback;
+}
+
+// Colunas que o glifo avança o cursor
+static inline uint8_t font_advance(const font_t *f, uint8_t glyph) {
+  return f->advance ? f->advance : f->widths[glyph] + f->spacing;
+}
@@ -0,0 +1,367 @@
+#!/usr/bin/env python3
+"""Gera as tabelas de fontes do painel (fonts.c e fonts.h) a partir dos
+desenhos em texto de fonts/*.txt.
+
+Formato da fonte:
+
+    font <nome>              identificador C da fonte (const font_t <nome>)
+    height <linhas>          altura dos glifos
+    advance <colunas>        passo fixo; sem ele a fonte é proporcional
+    spacing <colunas>        colunas vazias entre glifos proporcionais (padrão 1)
+    space <colunas>          largura do espaço numa fonte proporcional
+    fallback '<c>'           glifo dos caracteres sem desenho (padrão: o primeiro)
+    rle on|off               glifos compactados (padrão off)
+    variant <nome> [proportional] [spacing N] [space N] [rle on|off]
+                             outra fonte com os mesmos glifos e opções trocadas
+    glyph '<c>' | 0xNN       seguido de <height> linhas com '#' (aceso) e '.'
+
+Fora dos glifos, linhas vazias e linhas começando com '#' são ignoradas.
+
+Cada glifo sai no formato das páginas do SSD1306: para cada página de 8
+linhas, um byte por coluna com o bit 0 na linha de cima. Em fontes de passo
+fixo o glifo ocupa a célula inteira (colunas vazias à direita incluídas), para
+que o desenho opaco limpe o fundo; nas proporcionais as colunas vazias das
+bordas são cortadas e a largura de cada glifo vai na tabela widths.
+
+A compactação é do tipo PackBits, glifo a glifo: um byte de controle n < 128
+é seguido de n + 1 bytes literais; n >= 128 repete o byte seguinte n - 126
+vezes. Glifos em que ela não ajuda também passam por ela, para que a
+descompactação não precise de exceções.
+"""
+
+import argparse
+import os
+import sys
+
+FONT_MAX_GLYPH_BYTES = 256  # Mesmo valor de font.h
+FONT_NO_GLYPH = 0xFF
+
+
+class FontError(Exception):
+    pass
+
+
+class Font:
+    def __init__(self, name, source):
+        self.name = name
+        self.source = source
+        self.height = None
+        self.advance = 0
+        self.spacing = 1
+        self.space = None
+        self.fallback = None
+        self.rle = False
+        self.glyphs = {}  # código -> lista de linhas (strings de '#'/'.')
+        self.variants = []
+
+    def derive(self, name, opts):
+        f = Font(name, self.source)
+        f.height, f.advance, f.spacing, f.space = self.height, self.advance, self.spacing, self.space
+        f.fallback, f.rle, f.glyphs = self.fallback, self.rle, self.glyphs
+        i = 0
+        while i < len(opts):
+            opt = opts[i]
+            if opt == "proportional":
+                f.advance = 0
+                i += 1
+            elif opt in ("spacing", "space", "rle") and i + 1 < len(opts):
+                if opt == "rle":
+                    f.rle = parse_bool(opts[i + 1])
+                else:
+                    setattr(f, opt, int(opts[i + 1], 0))
+                i += 2
+            else:
+                raise FontError("variant %s: opção inválida '%s'" % (name, opt))
+        return f
+
+
+def parse_bool(text):
+    if text not in ("on", "off"):
+        raise FontError("esperado on ou off, veio '%s'" % text)
+    return text == "on"
+
+
+def parse_code(text):
+    if len(text) == 3 and text[0] == text[2] == "'":
+        return ord(text[1])
+    code = int(text, 0)
+    if not 0 <= code <= 0xFF:
+        raise FontError("código fora de um byte: %s" % text)
+    return code
+
+
+def parse(path):
+    font = None
+    with open(path, encoding="utf-8") as fp:
+        lines = [l.rstrip("\n") for l in fp]
+    n = 0
+
+    def fail(msg):
+        raise FontError("%s:%d: %s" % (path, n, msg))
+
+    while n < len(lines):
+        line = lines[n].strip()
+        n += 1
+        if not line or line.startswith("#"):
+            continue
+        key, _, rest = line.partition(" ")
+        rest = rest.strip()
+        if key == "font":
+            if font:
+                fail("só uma fonte por arquivo (use variant)")
+            font = Font(rest, path)
+            continue
+        if font is None:
+            fail("'%s' antes de 'font'" % key)
+        try:
+            if key == "height":
+                font.height = int(rest, 0)
+            elif key in ("advance", "spacing", "space"):
+                setattr(font, key, int(rest, 0))
+            elif key == "fallback":
+                font.fallback = parse_code(rest)
+            elif key == "rle":
+                font.rle = parse_bool(rest)
+            elif key == "variant":
+                opts = rest.split()
+                font.variants.append((opts[0], opts[1:]))
+            elif key == "glyph":
+                if font.height is None:
+                    fail("'glyph' antes de 'height'")
+                code = parse_code(rest)
+                if code in font.glyphs:
+                    fail("glifo 0x%02X repetido" % code)
+                rows = [l.strip() for l in lines[n:n + font.height]]
+                n += font.height
+                if len(rows) < font.height or any(set(r) - set("#.") or not r for r in rows):
+                    fail("glifo 0x%02X: esperadas %d linhas de '#' e '.'" % (code, font.height))
+                if len({len(r) for r in rows}) != 1:
+                    fail("glifo 0x%02X: linhas de larguras diferentes" % code)
+                font.glyphs[code] = rows
+            else:
+                fail("diretiva desconhecida '%s'" % key)
+        except ValueError as e:
+            fail(str(e))
+    if font is None or font.height is None or not font.glyphs:
+        raise FontError("%s: fonte sem nome, altura ou glifos" % path)
+    return [font] + [font.derive(name, opts) for name, opts in font.variants]
+
+
+def columns(rows):
+    """Linhas de '#'/'.' -> matriz de colunas (lista de listas de bits)."""
+    return [[rows[y][x] == "#" for y in range(len(rows))] for x in range(len(rows[0]))]
+
+
+def encode_pages(cols, height):
+    pages = (height + 7) // 8
+    out = []
+    for p in range(pages):
+        for col in cols:
+            byte = 0
+            for bit in range(8):
+                y = p * 8 + bit
+                if y < height and col[y]:
+                    byte |= 1 << bit
+            out.append(byte)
+    return out
+
+
+def packbits(data):
+    out = []
+    i = 0
+    literal = []
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:128]
+            del literal[:128]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and data[i + run] == data[i] and run < 129:
+            run += 1
+        if run >= 2:
+            flush_literal()
+            out.extend([run + 126, data[i]])
+            i += run
+        else:
+            literal.append(data[i])
+            i += 1
+    flush_literal()
+    return out
+
+
+def unpackbits(data):
+    out = []
+    i = 0
+    while i < len(data):
+        n = data[i]
+        if n < 128:
+            out.extend(data[i + 1:i + 2 + n])
+            i += n + 2
+        else:
+            out.extend([data[i + 1]] * (n - 126))
+            i += 2
+    return out
+
+
+def build(font):
+    codes = sorted(font.glyphs)
+    if len(codes) > 255:
+        raise FontError("%s: mais de 255 glifos" % font.name)
+    if font.spacing > 8:
+        raise FontError("%s: spacing acima de 8 colunas" % font.name)
+    widths, bitmaps, offsets = [], [], []
+    raw_size = 0
+    for code in codes:
+        cols = columns(font.glyphs[code])
+        if font.advance:
+            if len(cols) > font.advance:
+                raise FontError("%s: glifo 0x%02X mais largo que advance" % (font.name, code))
+            cols += [[False] * font.height] * (font.advance - len(cols))
+        else:
+            lit = [i for i, c in enumerate(cols) if any(c)]
+            if lit:
+                cols = cols[lit[0]:lit[-1] + 1]
+            else:
+                space = font.space if font.space is not None else max(1, font.height // 3)
+                cols = [[False] * font.height] * space
+        data = encode_pages(cols, font.height)
+        if len(data) > FONT_MAX_GLYPH_BYTES:
+            raise FontError("%s: glifo 0x%02X com %d bytes, acima de FONT_MAX_GLYPH_BYTES"
+                            % (font.name, code, len(data)))
+        raw_size += len(data)
+        if font.rle:
+            packed = packbits(data)
+            assert unpackbits(packed) == data
+            data = packed
+        offsets.append(len(bitmaps))
+        widths.append(len(cols))
+        bitmaps.extend(data)
+    offsets.append(len(bitmaps))
+    if offsets[-1] > 0xFFFF:
+        raise FontError("%s: bitmaps acima de 64 KiB" % font.name)
+
+    fallback = codes.index(font.fallback) if font.fallback is not None else 0
+    if font.fallback is not None and font.fallback not in font.glyphs:
+        raise FontError("%s: fallback sem glifo" % font.name)
+
+    # Tabela densa quando a faixa de códigos é compacta; senão, lista ordenada
+    # dos códigos com busca binária
+    span = codes[-1] - codes[0] + 1
+    dense = span <= 2 * len(codes)
+    return {
+        "codes": codes,
+        "widths": widths,
+        "offsets": offsets,
+        "bitmaps": bitmaps,
+        "fallback": fallback,
+        "dense": dense,
+        "first": codes[0] if dense else 0,
+        "count": span if dense else len(codes),
+        "raw_size": raw_size,
+    }
+
+
+def c_array(ctype, name, values, per_line=16, fmt="0x%02X"):
+    lines = ["static const %s %s[%d] = {" % (ctype, name, len(values))]
+    for i in range(0, len(values), per_line):
+        lines.append("  " + ", ".join(fmt % v for v in values[i:i + per_line]) + ",")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def char_label(code):
+    return "'%s'" % chr(code) if 0x20 <= code < 0x7F and chr(code) not in "'\\" else "0x%02X" % code
+
+
+def emit(fonts, out_dir, sources):
+    os.makedirs(out_dir, exist_ok=True)
+    names = ", ".join(os.path.basename(s) for s in sources)
+    header = ["// Gerado por fonts/fontgen.py a partir de %s. Não editar." % names,
+              "", "#pragma once", "", '#include "font.h"', ""]
+    body = ["// Gerado por fonts/fontgen.py a partir de %s. Não editar." % names,
+            "", '#include "fonts.h"']
+
+    for font in fonts:
+        t = build(font)
+        n = font.name
+        header.append("extern const font_t %s;" % n)
+        if font.advance:
+            # Tamanho de um glifo descompactado, para buffers de glifos prontos
+            header.append("#define %s_CELL_BYTES %d" % (n.upper(), font.advance * ((font.height + 7) // 8)))
+        body.append("")
+        body.append("// %s: %d glifos, %d linhas, %s; %d bytes de bitmap%s" % (
+            n, len(t["codes"]), font.height,
+            "passo %d" % font.advance if font.advance else "proporcional",
+            len(t["bitmaps"]),
+            " (%d sem compactar)" % t["raw_size"] if font.rle else ""))
+        body.append("// Glifos: " + " ".join(char_label(c) for c in t["codes"]))
+        body.append(c_array("uint8_t", n + "_bitmaps", t["bitmaps"]))
+        body.append(c_array("uint16_t", n + "_offsets", t["offsets"], 12, "%d"))
+        body.append(c_array("uint8_t", n + "_widths", t["widths"], 16, "%d"))
+        if t["dense"]:
+            index = [FONT_NO_GLYPH] * t["count"]
+            for g, code in enumerate(t["codes"]):
+                index[code - t["first"]] = g
+            body.append(c_array("uint8_t", n + "_map", index, 16, "%3d"))
+        else:
+            body.append(c_array("uint8_t", n + "_codes", t["codes"]))
+        body.append("")
+        body.append("const font_t %s = {" % n)
+        body.append("  .height = %d," % font.height)
+        body.append("  .pages = %d," % ((font.height + 7) // 8))
+        body.append("  .advance = %d," % font.advance)
+        body.append("  .spacing = %d," % (0 if font.advance else font.spacing))
+        body.append("  .n_glyphs = %d," % len(t["codes"]))
+        body.append("  .fallback = %d," % t["fallback"])
+        body.append("  .rle = %s," % ("true" if font.rle else "false"))
+        body.append("  .first = %d," % t["first"])
+        body.append("  .count = %d," % t["count"])
+        if t["dense"]:
+            body.append("  .map = %s_map," % n)
+        else:
+            body.append("  .codes = %s_codes," % n)
+        body.append("  .widths = %s_widths," % n)
+        body.append("  .offsets = %s_offsets," % n)
+        body.append("  .bitmaps = %s_bitmaps," % n)
+        body.append("};")
+
+    write_if_changed(os.path.join(out_dir, "fonts.h"), "\n".join(header) + "\n")
+    write_if_changed(os.path.join(out_dir, "fonts.c"), "\n".join(body) + "\n")
+
+
+# Não reescreve arquivos iguais, para não recompilar quem inclui fonts.h
+def write_if_changed(path, text):
+    try:
+        with open(path, encoding="utf-8") as fp:
+            if fp.read() == text:
+                return
+    except OSError:
+        pass
+    with open(path, "w", encoding="utf-8", newline="\n") as fp:
+        fp.write(text)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("-o", "--output", required=True, help="diretório de fonts.c e fonts.h")
+    ap.add_argument("sources", nargs="+", help="arquivos de fonte (.txt)")
+    args = ap.parse_args()
+    try:
+        fonts = []
+        for src in args.sources:
+            fonts.extend(parse(src))
+        if len({f.name for f in fonts}) != len(fonts):
+            raise FontError("nomes de fonte repetidos")
+        emit(fonts, args.output, args.sources)
+    except FontError as e:
+        print("fontgen: %s" % e, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,27 @@
+# Tabelas de fontes geradas na compilação: fontgen.py converte os desenhos em
+# texto (fonts/*.txt) em fonts.c e fonts.h no diretório de build.
+# painel_add_fonts(<alvo>) liga o alvo às tabelas.
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(PAINEL_FONTS_SOURCES
+        ${CMAKE_CURRENT_LIST_DIR}/font_8x8.txt
+        ${CMAKE_CURRENT_LIST_DIR}/digitos_16x24.txt
+)
+set(PAINEL_FONTS_DIR ${CMAKE_CURRENT_BINARY_DIR}/fonts)
+
+add_custom_command(
+        OUTPUT ${PAINEL_FONTS_DIR}/fonts.c ${PAINEL_FONTS_DIR}/fonts.h
+        COMMAND ${Python3_EXECUTABLE} ${CMAKE_CURRENT_LIST_DIR}/fontgen.py -o ${PAINEL_FONTS_DIR} ${PAINEL_FONTS_SOURCES}
+        DEPENDS ${CMAKE_CURRENT_LIST_DIR}/fontgen.py ${PAINEL_FONTS_SOURCES}
+        COMMENT "Gerando tabelas de fontes"
+        VERBATIM
+)
+# Um único alvo gera as tabelas, para que os executáveis não as gerem em paralelo
+add_custom_target(painel_fonts DEPENDS ${PAINEL_FONTS_DIR}/fonts.c ${PAINEL_FONTS_DIR}/fonts.h)
+
+function(painel_add_fonts target)
+    target_sources(${target} PRIVATE ${PAINEL_FONTS_DIR}/fonts.c)
+    target_include_directories(${target} PRIVATE ${PAINEL_FONTS_DIR})
+    add_dependencies(${target} painel_fonts)
+endfunction()
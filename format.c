@@ -0,0 +1,43 @@
+#include "format.h"
+
+// Escreve value em decimal alinhado à direita em width caracteres, completando
+// à esquerda com pad. Com width 0, ou se o número não couber, usa só os
+// dígitos necessários. Retorna o comprimento, sem o '\0'
+uint8_t format_uint(char *buf, uint32_t value, uint8_t width, char pad) {
+  char digits[FORMAT_UINT_MAX];
+  uint8_t n = 0;
+  do {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value);
+
+  uint8_t len = 0;
+  while (len + n < width)
+    buf[len++] = pad;
+  while (n)
+    buf[len++] = digits[--n];
+  buf[len] = '\0';
+  return len;
+}
+
+// Como format_uint, com '-' antes dos números negativos: colado aos dígitos,
+// ou na frente dos zeros quando pad é '0'
+uint8_t format_int(char *buf, int32_t value, uint8_t width, char pad) {
+  if (value >= 0)
+    return format_uint(buf, value, width, pad);
+  uint8_t len = format_uint(buf + 1, -(uint32_t)value, width ? width - 1 : 0, pad) + 1;
+  uint8_t i = 0;
+  if (pad != '0') {
+    for (; buf[i + 1] == pad; ++i)
+      buf[i] = pad;
+  }
+  buf[i] = '-';
+  return len;
+}
+
+// Copia src para dst e retorna o fim (o '\0'), para encadear partes de um texto
+char *format_append(char *dst, const char *src) {
+  while ((*dst = *src++))
+    ++dst;
+  return dst;
+}
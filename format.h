@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+
+// Formatação de inteiros sem printf: nada de pilha ou heap da newlib no
+// caminho do quadro. Os buffers são do chamador e precisam de espaço para o
+// número, o preenchimento e o '\0'
+
+#define FORMAT_UINT_MAX 10 // Dígitos de um uint32_t
+
+uint8_t format_uint(char *buf, uint32_t value, uint8_t width, char pad);
+uint8_t format_int(char *buf, int32_t value, uint8_t width, char pad);
+char *format_append(char *dst, const char *src);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "pico.h"
+
+// Registradores do ADC; a simulação atende as leituras do DMA em fifo
+typedef struct {
+  volatile uint32_t cs;
+  volatile uint32_t result;
+  volatile uint32_t fcs;
+  volatile uint32_t fifo;
+  volatile uint32_t div;
+  volatile uint32_t intr;
+  volatile uint32_t inte;
+  volatile uint32_t intf;
+  volatile uint32_t ints;
+} adc_hw_t;
+
+extern adc_hw_t sim_adc_hw;
+#define adc_hw (&sim_adc_hw)
+
+void adc_init(void);
+void adc_gpio_init(uint gpio);
+void adc_select_input(uint input);
+uint adc_get_selected_input(void);
+uint16_t adc_read(void);
+void adc_set_round_robin(uint input_mask);
+void adc_set_clkdiv(float clkdiv);
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift);
+void adc_fifo_drain(void);
+bool adc_fifo_is_empty(void);
+uint8_t adc_fifo_get_level(void);
+void adc_run(bool run);
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "pico.h"
+
+// Registradores do controlador I2C usados pelos drivers; a simulação acompanha
+// tar, enable, status e as escritas do DMA em data_cmd; um NACK num envio por
+// DMA aparece em raw_intr_stat e tx_abrt_source
+typedef struct {
+  volatile uint32_t con;
+  volatile uint32_t tar;
+  volatile uint32_t data_cmd;
+  volatile uint32_t intr_stat;
+  volatile uint32_t intr_mask;
+  volatile uint32_t raw_intr_stat;
+  volatile uint32_t clr_intr;
+  volatile uint32_t clr_tx_abrt;
+  volatile uint32_t clr_stop_det;
+  volatile uint32_t enable;
+  volatile uint32_t status;
+  volatile uint32_t txflr;
+  volatile uint32_t rxflr;
+  volatile uint32_t tx_abrt_source;
+  volatile uint32_t dma_cr;
+  volatile uint32_t enable_status;
+} i2c_hw_t;
+
+#define I2C_IC_DATA_CMD_CMD_BITS 0x00000100u
+#define I2C_IC_DATA_CMD_STOP_BITS 0x00000200u
+#define I2C_IC_DATA_CMD_RESTART_BITS 0x00000400u
+#define I2C_IC_STATUS_ACTIVITY_BITS 0x00000001u
+#define I2C_IC_STATUS_TFNF_BITS 0x00000002u
+#define I2C_IC_STATUS_TFE_BITS 0x00000004u
+#define I2C_IC_STATUS_RFNE_BITS 0x00000008u
+#define I2C_IC_STATUS_MST_ACTIVITY_BITS 0x00000020u
+#define I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS 0x00000040u
+#define I2C_IC_RAW_INTR_STAT_STOP_DET_BITS 0x00000200u
+#define I2C_IC_DMA_CR_TDMAE_BITS 0x00000002u
+#define I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS 0x00000001u
+#define I2C_IC_TX_ABRT_SOURCE_ABRT_TXDATA_NOACK_BITS 0x00000008u
+
+struct i2c_inst {
+  i2c_hw_t *hw;
+  bool restart_on_next;
+};
+typedef struct i2c_inst i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+
+#define DREQ_I2C0_TX 32
+#define DREQ_I2C0_RX 33
+#define DREQ_I2C1_TX 34
+#define DREQ_I2C1_RX 35
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+void i2c_deinit(i2c_inst_t *i2c);
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us);
+
+static inline uint i2c_hw_index(i2c_inst_t *i2c) {
+  return i2c == i2c1 ? 1 : 0;
+}
+
+static inline i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c) {
+  return i2c->hw;
+}
+
+static inline uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx) {
+  return i2c == i2c1 ? (is_tx ? DREQ_I2C1_TX : DREQ_I2C1_RX) : (is_tx ? DREQ_I2C0_TX : DREQ_I2C0_RX);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "pico.h"
+
+// Na simulação as interrupções são eventos entregues nos pontos de espera, então
+// desabilitá-las não tem efeito. __wfe cede o tempo até o registrador de evento
+// do núcleo ser ligado, por __sev ou por uma interrupção atendida por ele
+void __wfe(void);
+void __wfi(void);
+void __sev(void);
+
+static inline void __dmb(void) {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __mem_fence_acquire(void) {
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+static inline void __mem_fence_release(void) {
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline uint32_t save_and_disable_interrupts(void) {
+  return 0;
+}
+
+static inline void restore_interrupts(uint32_t status) {
+  (void)status;
+}
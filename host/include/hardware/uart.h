@@ -0,0 +1,59 @@
+#pragma once
+
+#include "pico.h"
+
+// Registradores da UART PL011; a simulação atende as leituras do DMA em dr
+typedef struct {
+  volatile uint32_t dr;
+  volatile uint32_t rsr;
+  volatile uint32_t fr;
+  volatile uint32_t ibrd;
+  volatile uint32_t fbrd;
+  volatile uint32_t lcr_h;
+  volatile uint32_t cr;
+  volatile uint32_t dmacr;
+} uart_hw_t;
+
+#define UART_UARTDMACR_TXDMAE_BITS 0x00000002u
+#define UART_UARTDMACR_RXDMAE_BITS 0x00000001u
+
+struct uart_inst {
+  uart_hw_t *hw;
+  uint baudrate;
+};
+typedef struct uart_inst uart_inst_t;
+
+extern uart_inst_t uart0_inst;
+extern uart_inst_t uart1_inst;
+
+#define uart0 (&uart0_inst)
+#define uart1 (&uart1_inst)
+
+#define DREQ_UART0_TX 20
+#define DREQ_UART0_RX 21
+#define DREQ_UART1_TX 22
+#define DREQ_UART1_RX 23
+
+typedef enum {
+  UART_PARITY_NONE,
+  UART_PARITY_EVEN,
+  UART_PARITY_ODD
+} uart_parity_t;
+
+uint uart_init(uart_inst_t *uart, uint baudrate);
+void uart_deinit(uart_inst_t *uart);
+uint uart_set_baudrate(uart_inst_t *uart, uint baudrate);
+void uart_set_format(uart_inst_t *uart, uint data_bits, uint stop_bits, uart_parity_t parity);
+void uart_set_fifo_enabled(uart_inst_t *uart, bool enabled);
+
+static inline uint uart_get_index(uart_inst_t *uart) {
+  return uart == uart1 ? 1 : 0;
+}
+
+static inline uart_hw_t *uart_get_hw(uart_inst_t *uart) {
+  return uart->hw;
+}
+
+static inline uint uart_get_dreq(uart_inst_t *uart, bool is_tx) {
+  return uart == uart1 ? (is_tx ? DREQ_UART1_TX : DREQ_UART1_RX) : (is_tx ? DREQ_UART0_TX : DREQ_UART0_RX);
+}
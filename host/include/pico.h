@@ -0,0 +1,33 @@
+#pragma once
+
+// Tipos e macros básicos do SDK para a compilação em host (PICO_ON_DEVICE = 0)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+typedef unsigned int uint;
+
+#define PICO_ON_DEVICE 0
+
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+#define __isr
+#define __aligned(x) __attribute__((aligned(x)))
+
+#define NUM_CORES 2
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+enum pico_error_codes {
+  PICO_OK = 0,
+  PICO_ERROR_NONE = 0,
+  PICO_ERROR_TIMEOUT = -1,
+  PICO_ERROR_GENERIC = -2,
+  PICO_ERROR_NO_DATA = -3,
+  PICO_ERROR_IO = -6,
+};
+
+// Núcleo que executa a chamada (0 ou 1)
+uint get_core_num(void);
@@ -0,0 +1,15 @@
+#pragma once
+
+// Subconjunto de pico_multicore para a compilação em host. Os dois núcleos são
+// corrotinas que se alternam nos pontos de espera (ver sim_core.c); a FIFO entre
+// eles tem a mesma profundidade da do RP2040
+
+#include "pico.h"
+
+void multicore_launch_core1(void (*entry)(void));
+
+bool multicore_fifo_rvalid(void);
+bool multicore_fifo_wready(void);
+void multicore_fifo_push_blocking(uint32_t data);
+uint32_t multicore_fifo_pop_blocking(void);
+void multicore_fifo_drain(void);
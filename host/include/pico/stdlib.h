@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdio.h>
+#include "pico.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+bool stdio_init_all(void);
+
+// No RP2040 é um laço vazio; na simulação cede o tempo ao próximo evento
+// pendente, para que esperas ativas terminem
+void tight_loop_contents(void);
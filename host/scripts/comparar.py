@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Compara duas execuções de painel_host sobre a mesma entrada.
+
+    comparar.py DIR_A DIR_B [--log LOG_A LOG_B]
+
+DIR_A e DIR_B são diretórios gravados com -o. Para cada CSV de quadros
+(oled*.csv, ws2812*.csv) mostra o número de quadros, o primeiro quadro em que
+os hashes divergem e o deslocamento de tempo dos quadros iguais até ali.
+Com --log, compara também as últimas linhas de telemetria da saída padrão de
+cada execução (p99 e média por etapa).
+
+Sai com status 1 se alguma sequência de quadros for diferente.
+"""
+
+import argparse
+import csv
+import os
+import sys
+
+
+def ler_quadros(path):
+    with open(path, newline='') as f:
+        return [(int(r['t_us']), r['hash']) for r in csv.DictReader(f)]
+
+
+def comparar_quadros(nome, a, b):
+    n = min(len(a), len(b))
+    diverge = next((i for i in range(n) if a[i][1] != b[i][1]), None)
+    iguais = n if diverge is None else diverge
+    desloc = [b[i][0] - a[i][0] for i in range(iguais)]
+    linha = f'{nome}: quadros {len(a)} -> {len(b)}'
+    if desloc:
+        linha += (f', atraso min={min(desloc)} us max={max(desloc)} us'
+                  f' medio={sum(desloc) / len(desloc):.0f} us')
+    if diverge is not None:
+        linha += f', diverge no quadro {diverge} (t={a[diverge][0]} us)'
+    elif len(a) != len(b):
+        linha += f', iguais até o quadro {n - 1}'
+    print(linha)
+    return diverge is None and len(a) == len(b)
+
+
+def ler_telemetria(path):
+    etapas = {}
+    with open(path, newline='') as f:
+        for campos in csv.reader(f):
+            if len(campos) == 7 and campos[0] == 'telemetria' and campos[2].isdigit():
+                etapas[campos[1]] = [int(c) for c in campos[2:]]
+    return etapas
+
+
+def comparar_telemetria(a, b):
+    print('telemetria,etapa,avg_us_a,avg_us_b,p99_us_a,p99_us_b')
+    for etapa in sorted(a.keys() & b.keys()):
+        ta, tb = a[etapa], b[etapa]
+        print(f'telemetria,{etapa},{ta[2]},{tb[2]},{ta[3]},{tb[3]}')
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('dir_a')
+    ap.add_argument('dir_b')
+    ap.add_argument('--log', nargs=2, metavar=('LOG_A', 'LOG_B'))
+    args = ap.parse_args()
+
+    csvs = sorted(n for n in set(os.listdir(args.dir_a)) | set(os.listdir(args.dir_b))
+                  if n.endswith('.csv'))
+    ok = True
+    for nome in csvs:
+        pa, pb = (os.path.join(d, nome) for d in (args.dir_a, args.dir_b))
+        if not (os.path.exists(pa) and os.path.exists(pb)):
+            print(f'{nome}: só em {args.dir_a if os.path.exists(pa) else args.dir_b}')
+            ok = False
+            continue
+        ok &= comparar_quadros(os.path.splitext(nome)[0], ler_quadros(pa), ler_quadros(pb))
+
+    if args.log:
+        comparar_telemetria(*(ler_telemetria(p) for p in args.log))
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""Envia quadros de dados do veículo (formato em ingest.h) no lugar do controlador.
+
+    veiculo.py [-p PORTA] [-b BAUD] [--hz HZ] [--erros N] [-d SEGUNDOS]
+
+Sem -p os bytes vão para a saída padrão. Numa porta serial (adaptador USB
+ligado ao pino 9 da placa) o script configura o modo bruto e a velocidade.
+O conteúdo segue o controlador simulado de painel_host --vehicle-hz: a
+velocidade sobe de 0 a 120 km/h em 8 s e desce em outros 8, o combustível
+cai de 9,0 L a 0,1 L a cada 100 ms e "MM On" fica ligado entre 6,0 e 6,5 s.
+Com --hz 0 os quadros saem um atrás do outro, no limite da linha; com
+--erros N, um a cada N quadros sai com um bit trocado.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import termios
+import time
+import tty
+
+SYNC = b'\xa5\x5a'
+FLAG_MM = 0x01
+BAUDS = {9600: termios.B9600, 19200: termios.B19200, 38400: termios.B38400, 57600: termios.B57600,
+         115200: termios.B115200, 230400: termios.B230400, 460800: termios.B460800,
+         921600: termios.B921600}
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = (crc << 1) ^ 0x1021 if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def quadro(seq, t_ms):
+    fase = t_ms % 16000
+    velocidade = (fase if fase < 8000 else 16000 - fase) * 1200 // 8000
+    combustivel = 90 - t_ms // 100 if t_ms < 9000 else 0
+    flags = FLAG_MM if 6000 <= t_ms < 6500 else 0
+    corpo = struct.pack('<BBHHB', 5, seq & 0xFF, velocidade, combustivel, flags)
+    return SYNC + corpo + struct.pack('<H', crc16(corpo))
+
+
+def abrir(porta, baud):
+    if porta is None:
+        return sys.stdout.buffer.fileno()
+    fd = os.open(porta, os.O_WRONLY | os.O_NOCTTY)
+    if os.isatty(fd):
+        tty.setraw(fd)
+        attrs = termios.tcgetattr(fd)
+        attrs[4] = attrs[5] = BAUDS[baud]
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('-p', '--porta')
+    ap.add_argument('-b', '--baud', type=int, default=115200, choices=sorted(BAUDS))
+    ap.add_argument('--hz', type=float, default=100, help='quadros por segundo (0 = sem pausa)')
+    ap.add_argument('--erros', type=int, default=0)
+    ap.add_argument('-d', '--duracao', type=float, default=0, help='segundos (0 = sem fim)')
+    args = ap.parse_args()
+
+    fd = abrir(args.porta, args.baud)
+    inicio = time.monotonic()
+    n = 0
+    try:
+        while True:
+            agora = time.monotonic() - inicio
+            if args.duracao and agora >= args.duracao:
+                break
+            q = bytearray(quadro(n, int(agora * 1000)))
+            if args.erros and (n + 1) % args.erros == 0:
+                q[4 + n % 5] ^= 0x10
+            os.write(fd, q)
+            n += 1
+            if args.hz > 0:
+                espera = inicio + n / args.hz - time.monotonic()
+                if espera > 0:
+                    time.sleep(espera)
+    except (KeyboardInterrupt, BrokenPipeError):
+        pass
+    print(f'{n} quadros em {time.monotonic() - inicio:.1f} s', file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
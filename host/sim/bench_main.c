@@ -0,0 +1,11 @@
+#include "sim.h"
+
+// bench.c é compilado com main renomeada para bench_main
+int bench_main(void);
+
+int main(int argc, char **argv) {
+  // Sem limite de tempo simulado, salvo -d explícito
+  sim_opt.duration_ms = 0;
+  sim_init(argc, argv);
+  return bench_main();
+}
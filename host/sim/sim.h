@@ -0,0 +1,82 @@
+#pragma once
+
+// Núcleo da simulação do RP2040 em host. O tempo é virtual e só avança nas
+// esperas (sleep, tight_loop_contents) e nas transferências bloqueantes; os
+// eventos agendados (fim de DMA, entradas do roteiro, varredura dos painéis)
+// rodam nesses pontos, no papel das interrupções.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define SIM_MAX_OLEDS 4
+#define SIM_MAX_I2C_FAULTS 4
+
+// Falha injetada num painel (--i2c-fault)
+typedef struct {
+  char kind;            // 'n': não responde (e volta desligado); 's': segura SDA em baixo
+  uint8_t bus, address;
+  uint32_t start_ms, duration_ms;
+} sim_i2c_fault_t;
+
+typedef void (*sim_event_fn_t)(void *arg);
+typedef void (*sim_report_fn_t)(FILE *out);
+
+typedef struct {
+  uint32_t duration_ms;   // Fim da simulação em tempo virtual
+  const char *script;     // Roteiro de entradas (ADC e GPIO)
+  const char *replay;     // Entradas gravadas pelo firmware (trace.h)
+  const char *out_dir;    // Diretório para os quadros capturados
+  uint32_t adc_noise;     // Amplitude do ruído somado às leituras do ADC
+  uint32_t vsync_hz;      // Frequência de varredura dos painéis OLED
+  uint32_t oled_max_hz;   // Maior frequência de I2C que os painéis aceitam
+  uint32_t vehicle_hz;    // Quadros por segundo do controlador simulado na UART1 (0 = sem)
+  uint32_t vehicle_errors; // Um quadro corrompido a cada N
+  unsigned n_oleds;       // Painéis presentes no barramento
+  uint8_t oled_bus[SIM_MAX_OLEDS];
+  uint8_t oled_addr[SIM_MAX_OLEDS];
+  unsigned n_i2c_faults;
+  sim_i2c_fault_t i2c_faults[SIM_MAX_I2C_FAULTS];
+} sim_options_t;
+
+extern sim_options_t sim_opt;
+
+void sim_init(int argc, char **argv);
+
+uint64_t sim_now_ns(void);
+void sim_schedule_ns(uint64_t at_ns, sim_event_fn_t fn, void *arg);
+void sim_cancel(sim_event_fn_t fn, void *arg);
+void sim_advance_to_ns(uint64_t t_ns);
+void sim_idle(void);
+
+void sim_irq_raise(unsigned num);
+
+void sim_add_report(sim_report_fn_t fn);
+FILE *sim_open_output(const char *name);
+
+#define SIM_HASH_INIT 0xcbf29ce484222325ull
+uint64_t sim_hash(uint64_t h, const void *data, size_t len);
+
+// Ponto de acesso de um periférico para o DMA: transfer consome (escrita no
+// registrador) ou produz (leitura) count elementos de size bytes em mem e
+// retorna a duração da transferência; complete é chamado ao final dela.
+// remaining, opcional, diz quantos elementos da transferência em curso ainda
+// não passaram pelo registrador; sem ele o progresso é linear na duração
+typedef struct {
+  volatile void *reg;
+  uint64_t (*transfer)(void *ctx, volatile void *mem, uint32_t count, unsigned size, bool incr);
+  uint32_t (*remaining)(void *ctx);
+  void (*complete)(void *ctx);
+  void *ctx;
+} sim_dma_endpoint_t;
+
+void sim_dma_register_endpoint(const sim_dma_endpoint_t *ep);
+
+void sim_gpio_start(void);
+void sim_i2c_start(void);
+void sim_uart_start(void);
+
+// Pinos de I2C usados como GPIO na recuperação do barramento
+bool sim_i2c_sda_held(unsigned bus);
+void sim_i2c_scl_pulse(unsigned bus);
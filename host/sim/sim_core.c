@@ -0,0 +1,647 @@
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <ucontext.h>
+#include "sim.h"
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+
+#define SIM_MAX_EVENTS 256
+#define SIM_MAX_REPORTS 16
+#define SIM_MAX_SHARED 8
+#define SIM_MAX_ALARMS 32
+#define SIM_MAX_POOLS 4
+#define SIM_DEFAULT_POOL_TIMERS 16 // Mesmo limite do pool padrão do SDK
+#define SIM_CORE1_STACK (256 * 1024)
+#define SIM_FIFO_DEPTH 8 // Profundidade de cada sentido da FIFO entre núcleos
+
+typedef struct {
+  uint64_t at;
+  sim_event_fn_t fn;
+  void *arg;
+} sim_event_t;
+
+sim_options_t sim_opt = {
+  .duration_ms = 10000,
+  .vsync_hz = 100,
+  .oled_max_hz = 1000000,
+};
+
+// Fila de eventos ordenada por instante; eventos simultâneos mantêm a ordem de chegada
+static sim_event_t events[SIM_MAX_EVENTS];
+static unsigned n_events;
+static uint64_t now_ns;
+static uint64_t end_ns = UINT64_MAX;
+
+static sim_report_fn_t reports[SIM_MAX_REPORTS];
+static unsigned n_reports;
+
+// Pool de alarmes: como no SDK, a interrupção dele fica no núcleo que o criou
+struct alarm_pool {
+  uint core;
+  uint max_timers;
+};
+
+typedef struct {
+  alarm_id_t id;
+  alarm_pool_t *pool;
+  uint64_t target_us;
+  alarm_callback_t callback;
+  void *user_data;
+} sim_alarm_t;
+
+static sim_alarm_t alarms[SIM_MAX_ALARMS];
+static alarm_id_t next_alarm_id = 1;
+static alarm_pool_t pools[SIM_MAX_POOLS] = {{.core = 0, .max_timers = SIM_DEFAULT_POOL_TIMERS}};
+static unsigned n_pools = 1;
+
+// Núcleos como corrotinas: cada um roda até esperar (sleep, __wfe, transferência
+// bloqueante) e só então o outro ganha a vez. O relógio virtual é um só e avança
+// quando os dois estão esperando, até o despertar mais cedo. Como no Cortex-M0+,
+// __wfe só volta com o registrador de evento do núcleo ligado: por __sev de
+// qualquer núcleo ou por uma interrupção (ou alarme) atendida por ele
+typedef struct {
+  ucontext_t ctx;
+  uint64_t wake_ns; // Instante em que a espera atual termina
+  bool running;     // Núcleo 1 lançado e ainda não retornou
+  bool in_wfe;      // Espera encerrada por um evento do núcleo
+  bool event;       // Registrador de evento, consumido por __wfe
+} sim_core_t;
+
+static sim_core_t cores[NUM_CORES] = {[0] = {.running = true}};
+static uint current_core;
+static void (*core1_entry)(void);
+
+typedef struct {
+  uint32_t data[SIM_FIFO_DEPTH];
+  unsigned head, count;
+} sim_fifo_t;
+
+static sim_fifo_t fifos[NUM_CORES]; // fifos[n]: mensagens destinadas ao núcleo n
+
+static irq_handler_t irq_handlers[NUM_IRQS][SIM_MAX_SHARED];
+static bool irq_enabled[NUM_IRQS];
+static bool irq_pending[NUM_IRQS];
+static uint irq_core[NUM_IRQS]; // Núcleo que habilitou a interrupção (NVIC de cada núcleo)
+
+uint64_t sim_now_ns(void) {
+  return now_ns;
+}
+
+void sim_schedule_ns(uint64_t at_ns, sim_event_fn_t fn, void *arg) {
+  if (n_events == SIM_MAX_EVENTS) {
+    fprintf(stderr, "sim: fila de eventos cheia\n");
+    abort();
+  }
+  if (at_ns < now_ns)
+    at_ns = now_ns;
+  unsigned i = n_events++;
+  while (i > 0 && events[i - 1].at > at_ns) {
+    events[i] = events[i - 1];
+    --i;
+  }
+  events[i] = (sim_event_t){at_ns, fn, arg};
+}
+
+void sim_cancel(sim_event_fn_t fn, void *arg) {
+  unsigned j = 0;
+  for (unsigned i = 0; i < n_events; ++i) {
+    if (events[i].fn != fn || events[i].arg != arg)
+      events[j++] = events[i];
+  }
+  n_events = j;
+}
+
+static void sim_run_events_to(uint64_t t_ns) {
+  if (t_ns > end_ns)
+    t_ns = end_ns;
+  while (n_events > 0 && events[0].at <= t_ns) {
+    sim_event_t ev = events[0];
+    memmove(&events[0], &events[1], --n_events * sizeof(sim_event_t));
+    if (ev.at > now_ns)
+      now_ns = ev.at;
+    ev.fn(ev.arg);
+  }
+  if (t_ns > now_ns)
+    now_ns = t_ns;
+  if (now_ns >= end_ns)
+    exit(0);
+}
+
+static void sim_switch_core(void) {
+  uint from = current_core;
+  current_core ^= 1;
+  swapcontext(&cores[from].ctx, &cores[current_core].ctx);
+}
+
+// Espera do núcleo atual até t_ns; enquanto isso o outro núcleo roda o que
+// puder no instante atual, e os eventos avançam até o despertar mais próximo
+static void sim_core_wait(uint64_t t_ns, bool wfe) {
+  sim_core_t *self = &cores[current_core];
+  sim_core_t *other = &cores[current_core ^ 1];
+  self->wake_ns = t_ns;
+  self->in_wfe = wfe;
+  for (;;) {
+    if (other->running && other->wake_ns <= now_ns) {
+      sim_switch_core();
+      continue;
+    }
+    uint64_t next = self->wake_ns;
+    if (other->running && other->wake_ns < next)
+      next = other->wake_ns;
+    // Um instante de eventos por vez: um deles pode acordar um dos núcleos
+    if (n_events > 0 && events[0].at < next)
+      next = events[0].at;
+    // Roda também os eventos do instante atual antes de devolver a vez
+    sim_run_events_to(next);
+    if (now_ns >= self->wake_ns)
+      break;
+  }
+  self->in_wfe = false;
+}
+
+void sim_advance_to_ns(uint64_t t_ns) {
+  if (cores[1].running)
+    sim_core_wait(t_ns, false);
+  else
+    sim_run_events_to(t_ns);
+}
+
+void sim_idle(void) {
+  uint64_t t_ns = n_events > 0 ? events[0].at : now_ns + 1000;
+  if (cores[1].running)
+    sim_core_wait(t_ns, true);
+  else
+    sim_run_events_to(t_ns);
+}
+
+// ---------------------------------------------------------------- tempo
+
+uint64_t time_us_64(void) {
+  return now_ns / 1000;
+}
+
+void sleep_us(uint64_t us) {
+  sim_advance_to_ns(now_ns + us * 1000);
+}
+
+void sleep_ms(uint32_t ms) {
+  sleep_us(ms * 1000ull);
+}
+
+void sleep_until(absolute_time_t t) {
+  if (t * 1000 > now_ns)
+    sim_advance_to_ns(t * 1000);
+}
+
+void busy_wait_us(uint64_t us) {
+  sleep_us(us);
+}
+
+void busy_wait_us_32(uint32_t us) {
+  sleep_us(us);
+}
+
+void busy_wait_ms(uint32_t ms) {
+  sleep_ms(ms);
+}
+
+void tight_loop_contents(void) {
+  sim_idle();
+}
+
+// Liga o registrador de evento do núcleo e encerra a espera dele
+static void sim_core_signal(uint core) {
+  sim_core_t *c = &cores[core];
+  c->event = true;
+  if (c->in_wfe && c->wake_ns > now_ns)
+    c->wake_ns = now_ns;
+}
+
+static void sim_alarm_fire(void *arg) {
+  sim_alarm_t *a = arg;
+  alarm_id_t id = a->id;
+  sim_core_signal(a->pool->core);
+  int64_t again = a->callback(id, a->user_data);
+  // O callback pode ter cancelado o próprio alarme
+  if (a->id != id)
+    return;
+  if (again == 0) {
+    a->id = 0;
+    return;
+  }
+  a->target_us = again > 0 ? a->target_us + again : now_ns / 1000 - again;
+  sim_schedule_ns(a->target_us * 1000, sim_alarm_fire, a);
+}
+
+alarm_pool_t *alarm_pool_get_default(void) {
+  return &pools[0];
+}
+
+alarm_pool_t *alarm_pool_create_with_unused_hardware_alarm(uint max_timers) {
+  if (n_pools == SIM_MAX_POOLS) {
+    fprintf(stderr, "sim: pools de alarmes demais\n");
+    abort();
+  }
+  alarm_pool_t *pool = &pools[n_pools++];
+  *pool = (alarm_pool_t){.core = current_core, .max_timers = max_timers};
+  return pool;
+}
+
+alarm_id_t alarm_pool_add_alarm_at(alarm_pool_t *pool, absolute_time_t time, alarm_callback_t callback,
+                                   void *user_data, bool fire_if_past) {
+  if (time * 1000 <= now_ns && !fire_if_past)
+    return 0;
+  unsigned used = 0;
+  for (unsigned i = 0; i < SIM_MAX_ALARMS; ++i)
+    used += alarms[i].id && alarms[i].pool == pool;
+  if (used == pool->max_timers)
+    return PICO_ERROR_GENERIC;
+  for (unsigned i = 0; i < SIM_MAX_ALARMS; ++i) {
+    sim_alarm_t *a = &alarms[i];
+    if (a->id)
+      continue;
+    a->id = next_alarm_id++;
+    if (next_alarm_id <= 0)
+      next_alarm_id = 1;
+    a->pool = pool;
+    a->target_us = time;
+    a->callback = callback;
+    a->user_data = user_data;
+    sim_schedule_ns(time * 1000, sim_alarm_fire, a);
+    return a->id;
+  }
+  return PICO_ERROR_GENERIC;
+}
+
+alarm_id_t alarm_pool_add_alarm_in_us(alarm_pool_t *pool, uint64_t us, alarm_callback_t callback, void *user_data,
+                                      bool fire_if_past) {
+  return alarm_pool_add_alarm_at(pool, time_us_64() + us, callback, user_data, fire_if_past);
+}
+
+alarm_id_t add_alarm_at(absolute_time_t time, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+  return alarm_pool_add_alarm_at(&pools[0], time, callback, user_data, fire_if_past);
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+  return add_alarm_at(time_us_64() + us, callback, user_data, fire_if_past);
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+  return add_alarm_in_us(ms * 1000ull, callback, user_data, fire_if_past);
+}
+
+bool alarm_pool_cancel_alarm(alarm_pool_t *pool, alarm_id_t alarm_id) {
+  for (unsigned i = 0; i < SIM_MAX_ALARMS; ++i) {
+    sim_alarm_t *a = &alarms[i];
+    if (alarm_id > 0 && a->id == alarm_id && a->pool == pool) {
+      sim_cancel(sim_alarm_fire, a);
+      a->id = 0;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+  return alarm_pool_cancel_alarm(&pools[0], alarm_id);
+}
+
+static int64_t sim_repeating_fire(alarm_id_t id, void *user_data) {
+  (void)id;
+  repeating_timer_t *rt = user_data;
+  if (!rt->callback(rt)) {
+    rt->alarm_id = 0;
+    return 0;
+  }
+  // Positivo reagenda a partir do instante anterior (início a início); negativo, a partir de agora
+  return -rt->delay_us;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out) {
+  if (delay_us == 0)
+    delay_us = 1;
+  out->delay_us = delay_us;
+  out->callback = callback;
+  out->user_data = user_data;
+  out->alarm_id = add_alarm_in_us(delay_us < 0 ? -delay_us : delay_us, sim_repeating_fire, out, true);
+  return out->alarm_id > 0;
+}
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data,
+                            repeating_timer_t *out) {
+  return add_repeating_timer_us(delay_ms * 1000ll, callback, user_data, out);
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer) {
+  bool cancelled = timer->alarm_id && cancel_alarm(timer->alarm_id);
+  timer->alarm_id = 0;
+  return cancelled;
+}
+
+void __wfe(void) {
+  sim_core_t *self = &cores[current_core];
+  while (!self->event) {
+    if (cores[1].running)
+      sim_core_wait(UINT64_MAX, true);
+    else
+      sim_idle();
+  }
+  self->event = false;
+}
+
+void __wfi(void) {
+  sim_idle();
+}
+
+void __sev(void) {
+  sim_core_signal(0);
+  sim_core_signal(1);
+}
+
+// ---------------------------------------------------------------- multicore
+
+uint get_core_num(void) {
+  return current_core;
+}
+
+static void sim_core1_main(void) {
+  core1_entry();
+  // Retornar da entrada encerra o núcleo 1 de vez
+  cores[1].running = false;
+  current_core = 0;
+  setcontext(&cores[0].ctx);
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+  static uint8_t *stack;
+  if (cores[1].running) {
+    fprintf(stderr, "sim: núcleo 1 já está em execução\n");
+    abort();
+  }
+  if (!stack)
+    stack = malloc(SIM_CORE1_STACK);
+  core1_entry = entry;
+  getcontext(&cores[1].ctx);
+  cores[1].ctx.uc_stack.ss_sp = stack;
+  cores[1].ctx.uc_stack.ss_size = SIM_CORE1_STACK;
+  cores[1].ctx.uc_link = NULL;
+  makecontext(&cores[1].ctx, sim_core1_main, 0);
+  cores[1].running = true;
+  cores[1].wake_ns = now_ns;
+}
+
+bool multicore_fifo_rvalid(void) {
+  return fifos[current_core].count > 0;
+}
+
+bool multicore_fifo_wready(void) {
+  return fifos[current_core ^ 1].count < SIM_FIFO_DEPTH;
+}
+
+void multicore_fifo_push_blocking(uint32_t data) {
+  sim_fifo_t *f = &fifos[current_core ^ 1];
+  while (f->count == SIM_FIFO_DEPTH)
+    __wfe();
+  f->data[(f->head + f->count++) % SIM_FIFO_DEPTH] = data;
+  __sev();
+}
+
+uint32_t multicore_fifo_pop_blocking(void) {
+  sim_fifo_t *f = &fifos[current_core];
+  while (f->count == 0)
+    __wfe();
+  uint32_t data = f->data[f->head];
+  f->head = (f->head + 1) % SIM_FIFO_DEPTH;
+  f->count--;
+  __sev();
+  return data;
+}
+
+void multicore_fifo_drain(void) {
+  fifos[current_core].count = 0;
+}
+
+bool stdio_init_all(void) {
+  return true;
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+  switch (clk_index) {
+    case clk_usb:
+    case clk_adc:
+      return 48000000;
+    case clk_ref:
+      return 12000000;
+    case clk_rtc:
+      return 46875;
+    default:
+      return 125000000;
+  }
+}
+
+// ---------------------------------------------------------------- interrupções
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+  memset(irq_handlers[num], 0, sizeof(irq_handlers[num]));
+  irq_handlers[num][0] = handler;
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority) {
+  (void)order_priority;
+  for (unsigned i = 0; i < SIM_MAX_SHARED; ++i) {
+    if (!irq_handlers[num][i]) {
+      irq_handlers[num][i] = handler;
+      return;
+    }
+  }
+  fprintf(stderr, "sim: tratadores demais na IRQ %u\n", num);
+  abort();
+}
+
+void irq_remove_handler(uint num, irq_handler_t handler) {
+  for (unsigned i = 0; i < SIM_MAX_SHARED; ++i) {
+    if (irq_handlers[num][i] == handler)
+      irq_handlers[num][i] = NULL;
+  }
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+  irq_enabled[num] = enabled;
+  if (enabled)
+    irq_core[num] = current_core;
+  if (enabled && irq_pending[num])
+    sim_irq_raise(num);
+}
+
+bool irq_is_enabled(uint num) {
+  return irq_enabled[num];
+}
+
+void irq_set_priority(uint num, uint8_t hardware_priority) {
+  (void)num;
+  (void)hardware_priority;
+}
+
+void sim_irq_raise(unsigned num) {
+  if (!irq_enabled[num]) {
+    irq_pending[num] = true;
+    return;
+  }
+  irq_pending[num] = false;
+  sim_core_signal(irq_core[num]);
+  for (unsigned i = 0; i < SIM_MAX_SHARED; ++i) {
+    if (irq_handlers[num][i])
+      irq_handlers[num][i]();
+  }
+}
+
+// ---------------------------------------------------------------- saídas
+
+uint64_t sim_hash(uint64_t h, const void *data, size_t len) {
+  const uint8_t *p = data;
+  for (size_t i = 0; i < len; ++i) {
+    h ^= p[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+void sim_add_report(sim_report_fn_t fn) {
+  if (n_reports < SIM_MAX_REPORTS)
+    reports[n_reports++] = fn;
+}
+
+FILE *sim_open_output(const char *name) {
+  if (!sim_opt.out_dir)
+    return NULL;
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s", sim_opt.out_dir, name);
+  FILE *f = fopen(path, "w");
+  if (!f)
+    fprintf(stderr, "sim: não foi possível criar %s\n", path);
+  return f;
+}
+
+static void sim_report(void) {
+  fflush(stdout);
+  fprintf(stderr, "sim: tempo=%.3f ms\n", now_ns / 1e6);
+  for (unsigned i = 0; i < n_reports; ++i)
+    reports[i](stderr);
+}
+
+// ---------------------------------------------------------------- opções
+
+static void sim_usage(const char *prog) {
+  fprintf(stderr,
+          "uso: %s [opções]\n"
+          "  -d, --duration MS     tempo virtual simulado, 0 para sem limite (padrão 10000)\n"
+          "  -s, --script ARQ      roteiro de entradas de ADC e GPIO\n"
+          "  -r, --replay ARQ      reproduz as entradas gravadas (linhas trace, da saída do firmware)\n"
+          "  -o, --out DIR         grava os quadros do OLED (PBM) e da matriz (CSV)\n"
+          "      --adc-noise N     ruído pseudoaleatório de +-N nas leituras do ADC\n"
+          "      --vsync-hz HZ     frequência de varredura dos painéis (padrão 100)\n"
+          "      --oled BUS:ADDR   painel SSD1306 no barramento (padrão 1:0x3C)\n"
+          "      --oled-max-hz HZ  acima dessa frequência de I2C os painéis não respondem (padrão 1000000)\n"
+          "      --vehicle-hz HZ   controlador do veículo enviando HZ quadros por segundo na UART1\n"
+          "      --vehicle-errors N  corrompe um a cada N quadros do controlador\n"
+          "      --i2c-fault TIPO:BUS:ADDR:INICIO_MS:DURACAO_MS\n"
+          "                        falha no painel: nack (some e volta religado) ou stuck (segura SDA)\n",
+          prog);
+}
+
+void sim_init(int argc, char **argv) {
+  static const struct option longopts[] = {
+    {"duration", required_argument, NULL, 'd'},
+    {"script", required_argument, NULL, 's'},
+    {"replay", required_argument, NULL, 'r'},
+    {"out", required_argument, NULL, 'o'},
+    {"adc-noise", required_argument, NULL, 'n'},
+    {"vsync-hz", required_argument, NULL, 'v'},
+    {"oled", required_argument, NULL, 'p'},
+    {"oled-max-hz", required_argument, NULL, 'm'},
+    {"vehicle-hz", required_argument, NULL, 'V'},
+    {"vehicle-errors", required_argument, NULL, 'E'},
+    {"i2c-fault", required_argument, NULL, 'F'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0},
+  };
+  int c;
+  while ((c = getopt_long(argc, argv, "d:s:r:o:h", longopts, NULL)) != -1) {
+    switch (c) {
+      case 'd':
+        sim_opt.duration_ms = strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        sim_opt.script = optarg;
+        break;
+      case 'r':
+        sim_opt.replay = optarg;
+        break;
+      case 'o':
+        sim_opt.out_dir = optarg;
+        mkdir(optarg, 0777);
+        break;
+      case 'n':
+        sim_opt.adc_noise = strtoul(optarg, NULL, 0);
+        break;
+      case 'v':
+        sim_opt.vsync_hz = strtoul(optarg, NULL, 0);
+        break;
+      case 'm':
+        sim_opt.oled_max_hz = strtoul(optarg, NULL, 0);
+        break;
+      case 'V':
+        sim_opt.vehicle_hz = strtoul(optarg, NULL, 0);
+        break;
+      case 'E':
+        sim_opt.vehicle_errors = strtoul(optarg, NULL, 0);
+        break;
+      case 'F': {
+        char kind[8];
+        unsigned bus, start, duration;
+        int address;
+        if (sim_opt.n_i2c_faults == SIM_MAX_I2C_FAULTS ||
+            sscanf(optarg, "%7[a-z]:%u:%i:%u:%u", kind, &bus, &address, &start, &duration) != 5 || bus > 1 ||
+            (strcmp(kind, "nack") != 0 && strcmp(kind, "stuck") != 0)) {
+          sim_usage(argv[0]);
+          exit(2);
+        }
+        sim_opt.i2c_faults[sim_opt.n_i2c_faults++] = (sim_i2c_fault_t){kind[0] == 's' ? 's' : 'n', bus, address, start, duration};
+        break;
+      }
+      case 'p': {
+        char *end;
+        unsigned long bus = strtoul(optarg, &end, 0);
+        if (*end != ':' || bus > 1 || sim_opt.n_oleds == SIM_MAX_OLEDS) {
+          sim_usage(argv[0]);
+          exit(2);
+        }
+        sim_opt.oled_bus[sim_opt.n_oleds] = bus;
+        sim_opt.oled_addr[sim_opt.n_oleds++] = strtoul(end + 1, NULL, 0);
+        break;
+      }
+      default:
+        sim_usage(argv[0]);
+        exit(c == 'h' ? 0 : 2);
+    }
+  }
+  if (sim_opt.n_oleds == 0) {
+    sim_opt.oled_bus[0] = 1;
+    sim_opt.oled_addr[0] = 0x3C;
+    sim_opt.n_oleds = 1;
+  }
+  if (sim_opt.vsync_hz == 0)
+    sim_opt.vsync_hz = 100;
+
+  end_ns = sim_opt.duration_ms ? sim_opt.duration_ms * 1000000ull : UINT64_MAX;
+  atexit(sim_report);
+  sim_gpio_start();
+  sim_i2c_start();
+  sim_uart_start();
+}
@@ -0,0 +1,286 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#define SIM_MAX_ENDPOINTS 16
+#define DMA_WORD_NS 8 // Memória para memória: uma palavra a cada ciclo de 125 MHz
+
+typedef struct {
+  bool claimed, busy, irq0_enabled, irq1_enabled, irq_raw;
+  dma_channel_config config;
+  volatile void *write_addr;
+  const volatile void *read_addr;
+  uint32_t trans_count;
+  uint64_t start_ns, end_ns; // Transferência em curso
+  const sim_dma_endpoint_t *endpoint;
+  uint64_t transfers, words;
+} sim_dma_channel_t;
+
+static sim_dma_channel_t channels[NUM_DMA_CHANNELS];
+static dma_channel_hw_t channel_regs[NUM_DMA_CHANNELS];
+static sim_dma_endpoint_t endpoints[SIM_MAX_ENDPOINTS];
+static unsigned n_endpoints;
+static bool report_installed;
+
+static void dma_complete(void *arg);
+
+void sim_dma_register_endpoint(const sim_dma_endpoint_t *ep) {
+  if (n_endpoints == SIM_MAX_ENDPOINTS) {
+    fprintf(stderr, "sim: pontos de acesso de DMA demais\n");
+    abort();
+  }
+  endpoints[n_endpoints++] = *ep;
+}
+
+static const sim_dma_endpoint_t *dma_find_endpoint(const volatile void *addr) {
+  for (unsigned i = 0; i < n_endpoints; ++i) {
+    if (endpoints[i].reg == addr)
+      return &endpoints[i];
+  }
+  return NULL;
+}
+
+static void sim_dma_report(FILE *out) {
+  for (unsigned i = 0; i < NUM_DMA_CHANNELS; ++i) {
+    const sim_dma_channel_t *ch = &channels[i];
+    if (ch->transfers)
+      fprintf(out, "sim: dma%u transferencias=%llu palavras=%llu\n", i, (unsigned long long)ch->transfers,
+              (unsigned long long)ch->words);
+  }
+}
+
+// Inicia a transferência: um periférico como destino (ou origem) dita a
+// duração; entre memórias a cópia é feita já e só o término é adiado
+static void dma_trigger(uint channel) {
+  sim_dma_channel_t *ch = &channels[channel];
+  if (ch->busy)
+    sim_cancel(dma_complete, ch);
+  ch->busy = true;
+  ++ch->transfers;
+  ch->words += ch->trans_count;
+  unsigned size = 1u << ch->config.size;
+  uint64_t ns;
+  const sim_dma_endpoint_t *ep = dma_find_endpoint(ch->write_addr);
+  if (!ep)
+    ep = dma_find_endpoint(ch->read_addr);
+  ch->endpoint = ep;
+  if (ep && ep->reg == ch->write_addr) {
+    ns = ep->transfer(ep->ctx, (volatile void *)ch->read_addr, ch->trans_count, size, ch->config.read_increment);
+  } else if (ep) {
+    ns = ep->transfer(ep->ctx, ch->write_addr, ch->trans_count, size, ch->config.write_increment);
+  } else {
+    volatile uint8_t *dst = ch->write_addr;
+    const volatile uint8_t *src = ch->read_addr;
+    for (uint32_t i = 0; i < ch->trans_count; ++i) {
+      for (unsigned b = 0; b < size; ++b)
+        dst[b] = src[b];
+      if (ch->config.write_increment)
+        dst += size;
+      if (ch->config.read_increment)
+        src += size;
+    }
+    ns = (uint64_t)ch->trans_count * DMA_WORD_NS;
+  }
+  ch->start_ns = sim_now_ns();
+  ch->end_ns = ch->start_ns + ns;
+  sim_schedule_ns(ch->end_ns, dma_complete, ch);
+}
+
+static void dma_complete(void *arg) {
+  sim_dma_channel_t *ch = arg;
+  uint channel = ch - channels;
+  ch->busy = false;
+  if (ch->endpoint && ch->endpoint->complete)
+    ch->endpoint->complete(ch->endpoint->ctx);
+  if (!ch->config.irq_quiet) {
+    // INTS0 e INTS1 são vistas mascaradas do mesmo INTR bruto
+    ch->irq_raw = true;
+    if (ch->irq0_enabled)
+      sim_irq_raise(DMA_IRQ_0);
+    if (ch->irq1_enabled)
+      sim_irq_raise(DMA_IRQ_1);
+  }
+  if (ch->config.chain_to != channel)
+    dma_trigger(ch->config.chain_to);
+}
+
+int dma_claim_unused_channel(bool required) {
+  for (uint i = 0; i < NUM_DMA_CHANNELS; ++i) {
+    if (!channels[i].claimed) {
+      dma_channel_claim(i);
+      return i;
+    }
+  }
+  if (required) {
+    fprintf(stderr, "sim: nenhum canal de DMA livre\n");
+    abort();
+  }
+  return -1;
+}
+
+void dma_channel_claim(uint channel) {
+  channels[channel].claimed = true;
+  if (!report_installed) {
+    sim_add_report(sim_dma_report);
+    report_installed = true;
+  }
+}
+
+void dma_channel_unclaim(uint channel) {
+  channels[channel].claimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+  return (dma_channel_config){
+    .size = DMA_SIZE_32,
+    .read_increment = true,
+    .write_increment = false,
+    .enable = true,
+    .dreq = DREQ_FORCE,
+    .chain_to = channel,
+  };
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+  c->size = size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+  c->read_increment = incr;
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+  c->write_increment = incr;
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+  c->dreq = dreq;
+}
+
+void channel_config_set_chain_to(dma_channel_config *c, uint chain_to) {
+  c->chain_to = chain_to;
+}
+
+void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+  c->ring_write = write;
+  c->ring_size_bits = size_bits;
+}
+
+void channel_config_set_irq_quiet(dma_channel_config *c, bool irq_quiet) {
+  c->irq_quiet = irq_quiet;
+}
+
+void channel_config_set_enable(dma_channel_config *c, bool enable) {
+  c->enable = enable;
+}
+
+void channel_config_set_high_priority(dma_channel_config *c, bool high_priority) {
+  c->high_priority = high_priority;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+  channels[channel].write_addr = write_addr;
+  channels[channel].read_addr = read_addr;
+  channels[channel].trans_count = transfer_count;
+  dma_channel_set_config(channel, config, trigger);
+}
+
+// Só transfer_count acompanha o canal; é lido na hora, como o contador do
+// hardware
+dma_channel_hw_t *dma_channel_hw_addr(uint channel) {
+  const sim_dma_channel_t *ch = &channels[channel];
+  dma_channel_hw_t *hw = &channel_regs[channel];
+  uint32_t left = 0;
+  if (ch->busy && ch->endpoint && ch->endpoint->remaining) {
+    left = ch->endpoint->remaining(ch->endpoint->ctx);
+  } else if (ch->busy && ch->end_ns > ch->start_ns) {
+    double done = (double)(sim_now_ns() - ch->start_ns) / (ch->end_ns - ch->start_ns);
+    left = ch->trans_count - (uint32_t)(done * ch->trans_count);
+  }
+  hw->read_addr = (uintptr_t)ch->read_addr;
+  hw->write_addr = (uintptr_t)ch->write_addr;
+  hw->transfer_count = left;
+  return hw;
+}
+
+void dma_channel_set_config(uint channel, const dma_channel_config *config, bool trigger) {
+  channels[channel].config = *config;
+  if (trigger)
+    dma_trigger(channel);
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+  channels[channel].read_addr = read_addr;
+  if (trigger)
+    dma_trigger(channel);
+}
+
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger) {
+  channels[channel].write_addr = write_addr;
+  if (trigger)
+    dma_trigger(channel);
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger) {
+  channels[channel].trans_count = trans_count;
+  if (trigger)
+    dma_trigger(channel);
+}
+
+void dma_channel_start(uint channel) {
+  dma_trigger(channel);
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count) {
+  channels[channel].read_addr = read_addr;
+  channels[channel].trans_count = transfer_count;
+  dma_trigger(channel);
+}
+
+void dma_channel_transfer_to_buffer_now(uint channel, volatile void *write_addr, uint32_t transfer_count) {
+  channels[channel].write_addr = write_addr;
+  channels[channel].trans_count = transfer_count;
+  dma_trigger(channel);
+}
+
+// O hardware para no meio; aqui a transferência é descartada por inteiro
+void dma_channel_abort(uint channel) {
+  sim_cancel(dma_complete, &channels[channel]);
+  channels[channel].busy = false;
+}
+
+bool dma_channel_is_busy(uint channel) {
+  return channels[channel].busy;
+}
+
+void dma_channel_wait_for_finish_blocking(uint channel) {
+  while (channels[channel].busy)
+    sim_idle();
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+  channels[channel].irq0_enabled = enabled;
+}
+
+bool dma_channel_get_irq0_status(uint channel) {
+  return channels[channel].irq_raw && channels[channel].irq0_enabled;
+}
+
+void dma_channel_acknowledge_irq0(uint channel) {
+  channels[channel].irq_raw = false;
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled) {
+  channels[channel].irq1_enabled = enabled;
+}
+
+bool dma_channel_get_irq1_status(uint channel) {
+  return channels[channel].irq_raw && channels[channel].irq1_enabled;
+}
+
+void dma_channel_acknowledge_irq1(uint channel) {
+  channels[channel].irq_raw = false;
+}
@@ -0,0 +1,461 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "hardware/gpio.h"
+#include "hardware/adc.h"
+#include "trace.h"
+
+#define ADC_CHANNELS 5
+#define ADC_SAMPLE_NS 2000 // 96 ciclos do relógio de 48 MHz
+#define ADC_CLOCK_HZ 48000000
+
+typedef struct {
+  gpio_function_t func;
+  bool out_dir, out_level;
+  bool pull_up, pull_down;
+  bool driven, driven_level; // Nível imposto pelo roteiro de entradas
+  bool i2c;                  // Já foi SDA (par) ou SCL (ímpar) do I2C (pino / 2) % 2
+  uint32_t irq_events;
+} sim_pin_t;
+
+typedef enum {
+  ACT_GPIO,
+  ACT_ADC,
+} sim_action_kind_t;
+
+typedef struct {
+  uint64_t at_ns;
+  sim_action_kind_t kind;
+  unsigned target;
+  unsigned value;
+} sim_action_t;
+
+static sim_pin_t pins[NUM_BANK0_GPIOS];
+static gpio_irq_callback_t irq_callback;
+static uint16_t adc_value[ADC_CHANNELS] = {2048, 2048, 2048, 2048, 876};
+static uint adc_selected;
+static uint adc_rr_mask;
+static float adc_clkdiv;
+static bool adc_running, adc_fifo_dreq;
+adc_hw_t sim_adc_hw;
+static uint32_t noise_state = 0x2545F491;
+static uint64_t gpio_edges, adc_reads;
+
+// Ações do roteiro em ordem de tempo; só a próxima fica na fila de eventos
+static sim_action_t *actions;
+static size_t n_actions, cap_actions, next_action;
+
+static bool pin_level(unsigned gpio) {
+  const sim_pin_t *p = &pins[gpio];
+  if (p->out_dir && p->func == GPIO_FUNC_SIO)
+    return p->out_level;
+  if (p->i2c && !(gpio & 1) && sim_i2c_sda_held((gpio >> 1) & 1))
+    return false;
+  if (p->driven)
+    return p->driven_level;
+  return p->pull_up;
+}
+
+// Muda o nível externo de um pino e dispara a interrupção de borda, se habilitada
+static void sim_gpio_drive(unsigned gpio, bool level) {
+  bool before = pin_level(gpio);
+  pins[gpio].driven = true;
+  pins[gpio].driven_level = level;
+  bool after = pin_level(gpio);
+  if (before == after)
+    return;
+  ++gpio_edges;
+  uint32_t event = after ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+  if ((pins[gpio].irq_events & event) && irq_callback)
+    irq_callback(gpio, event);
+}
+
+void gpio_init(uint gpio) {
+  pins[gpio].func = GPIO_FUNC_SIO;
+  pins[gpio].out_dir = false;
+  pins[gpio].out_level = false;
+}
+
+void gpio_deinit(uint gpio) {
+  pins[gpio].func = GPIO_FUNC_NULL;
+}
+
+void gpio_set_function(uint gpio, gpio_function_t fn) {
+  pins[gpio].func = fn;
+  if (fn == GPIO_FUNC_I2C)
+    pins[gpio].i2c = true;
+}
+
+gpio_function_t gpio_get_function(uint gpio) {
+  return pins[gpio].func;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+  sim_pin_t *p = &pins[gpio];
+  // SCL em dreno aberto: soltar o pino depois de puxá-lo para 0 é um pulso de clock
+  if (p->i2c && (gpio & 1) && p->func == GPIO_FUNC_SIO && p->out_dir && !p->out_level && !out)
+    sim_i2c_scl_pulse((gpio >> 1) & 1);
+  p->out_dir = out;
+}
+
+bool gpio_get_dir(uint gpio) {
+  return pins[gpio].out_dir;
+}
+
+void gpio_put(uint gpio, bool value) {
+  pins[gpio].out_level = value;
+}
+
+bool gpio_get(uint gpio) {
+  return pin_level(gpio);
+}
+
+void gpio_pull_up(uint gpio) {
+  pins[gpio].pull_up = true;
+  pins[gpio].pull_down = false;
+}
+
+void gpio_pull_down(uint gpio) {
+  pins[gpio].pull_up = false;
+  pins[gpio].pull_down = true;
+}
+
+void gpio_disable_pulls(uint gpio) {
+  pins[gpio].pull_up = pins[gpio].pull_down = false;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled) {
+  if (enabled)
+    pins[gpio].irq_events |= events;
+  else
+    pins[gpio].irq_events &= ~events;
+}
+
+void gpio_set_irq_callback(gpio_irq_callback_t callback) {
+  irq_callback = callback;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback) {
+  gpio_set_irq_enabled(gpio, events, enabled);
+  gpio_set_irq_callback(callback);
+}
+
+void gpio_acknowledge_irq(uint gpio, uint32_t events) {
+  (void)gpio;
+  (void)events;
+}
+
+// ---------------------------------------------------------------- ADC
+
+void adc_init(void) {
+  adc_selected = 0;
+}
+
+void adc_gpio_init(uint gpio) {
+  pins[gpio].func = GPIO_FUNC_NULL;
+  gpio_disable_pulls(gpio);
+}
+
+void adc_select_input(uint input) {
+  adc_selected = input % ADC_CHANNELS;
+}
+
+uint adc_get_selected_input(void) {
+  return adc_selected;
+}
+
+// Valor do canal com ruído uniforme determinístico (xorshift32)
+static uint16_t sim_adc_sample(unsigned channel) {
+  int value = adc_value[channel];
+  if (sim_opt.adc_noise) {
+    noise_state ^= noise_state << 13;
+    noise_state ^= noise_state >> 17;
+    noise_state ^= noise_state << 5;
+    value += (int)(noise_state % (2 * sim_opt.adc_noise + 1)) - (int)sim_opt.adc_noise;
+  }
+  if (value < 0)
+    value = 0;
+  if (value > 4095)
+    value = 4095;
+  ++adc_reads;
+  return value;
+}
+
+uint16_t adc_read(void) {
+  sim_advance_to_ns(sim_now_ns() + ADC_SAMPLE_NS);
+  return sim_adc_sample(adc_selected);
+}
+
+void adc_set_round_robin(uint input_mask) {
+  adc_rr_mask = input_mask & ((1u << ADC_CHANNELS) - 1);
+}
+
+void adc_set_clkdiv(float clkdiv) {
+  adc_clkdiv = clkdiv;
+}
+
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift) {
+  (void)dreq_thresh;
+  (void)err_in_fifo;
+  (void)byte_shift;
+  adc_fifo_dreq = en && dreq_en;
+}
+
+// A FIFO da simulação nunca acumula: as amostras vão direto para o DMA
+void adc_fifo_drain(void) {
+}
+
+bool adc_fifo_is_empty(void) {
+  return true;
+}
+
+uint8_t adc_fifo_get_level(void) {
+  return 0;
+}
+
+void adc_run(bool run) {
+  adc_running = run;
+}
+
+// Intervalo entre conversões em modo livre: 1 + div ciclos de 48 MHz, no mínimo 96
+static uint64_t adc_period_ns(void) {
+  double cycles = adc_clkdiv + 1.0;
+  if (cycles < 96.0)
+    cycles = 96.0;
+  return (uint64_t)(cycles * 1e9 / ADC_CLOCK_HZ);
+}
+
+// DMA lendo a FIFO: uma conversão por elemento, alternando os canais do
+// round robin a partir do selecionado, no ritmo do divisor. As amostras são
+// tomadas no início do bloco; um canal armado antes de adc_run() conta como
+// se a conversão já tivesse começado
+static uint64_t adc_dma_transfer(void *ctx, volatile void *mem, uint32_t count, unsigned size, bool incr) {
+  (void)ctx;
+  if (!adc_fifo_dreq) {
+    fprintf(stderr, "sim: DMA lendo a FIFO do ADC sem DREQ habilitado\n");
+    abort();
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    uint16_t sample = sim_adc_sample(adc_selected);
+    if (size == 2)
+      ((volatile uint16_t *)mem)[incr ? i : 0] = sample;
+    else if (size == 4)
+      ((volatile uint32_t *)mem)[incr ? i : 0] = sample;
+    else
+      ((volatile uint8_t *)mem)[incr ? i : 0] = sample >> 4;
+    if (adc_rr_mask) {
+      do {
+        adc_selected = (adc_selected + 1) % ADC_CHANNELS;
+      } while (!(adc_rr_mask & (1u << adc_selected)));
+    }
+  }
+  return count * adc_period_ns();
+}
+
+// ---------------------------------------------------------------- roteiro
+
+static void sim_run_actions(void *arg) {
+  (void)arg;
+  uint64_t now = sim_now_ns();
+  while (next_action < n_actions && actions[next_action].at_ns <= now) {
+    const sim_action_t *a = &actions[next_action++];
+    if (a->kind == ACT_GPIO)
+      sim_gpio_drive(a->target, a->value);
+    else
+      adc_value[a->target] = a->value;
+  }
+  if (next_action < n_actions)
+    sim_schedule_ns(actions[next_action].at_ns, sim_run_actions, NULL);
+}
+
+static void sim_add_action(uint64_t at_ns, sim_action_kind_t kind, unsigned target, unsigned value) {
+  if (n_actions == cap_actions) {
+    cap_actions = cap_actions ? cap_actions * 2 : 64;
+    actions = realloc(actions, cap_actions * sizeof(sim_action_t));
+  }
+  // Inserção estável: ações no mesmo instante mantêm a ordem do roteiro
+  size_t i = n_actions++;
+  while (i > 0 && actions[i - 1].at_ns > at_ns) {
+    actions[i] = actions[i - 1];
+    --i;
+  }
+  actions[i] = (sim_action_t){at_ns, kind, target, value};
+}
+
+// Formato, uma ação por linha (# inicia comentário):
+//   <t_ms> adc <canal> <valor 0-4095>
+//   <t_ms> gpio <pino> <0|1>
+//   <t_ms> press <pino> [duração_ms]   nível baixo e retorno ao alto (padrão 100 ms)
+// O tempo aceita fração de milissegundo.
+static void sim_load_script(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "sim: roteiro %s não encontrado\n", path);
+    exit(2);
+  }
+  char line[256];
+  unsigned lineno = 0;
+  while (fgets(line, sizeof(line), f)) {
+    ++lineno;
+    char *hash = strchr(line, '#');
+    if (hash)
+      *hash = '\0';
+    char cmd[16];
+    double t_ms;
+    unsigned a, b = 100;
+    int n = sscanf(line, "%lf %15s %u %u", &t_ms, cmd, &a, &b);
+    if (n <= 0)
+      continue;
+    uint64_t t = (uint64_t)(t_ms * 1e6 + 0.5);
+    if (n >= 4 && strcmp(cmd, "adc") == 0 && a < ADC_CHANNELS) {
+      sim_add_action(t, ACT_ADC, a, b > 4095 ? 4095 : b);
+    } else if (n >= 4 && strcmp(cmd, "gpio") == 0 && a < NUM_BANK0_GPIOS) {
+      sim_add_action(t, ACT_GPIO, a, b != 0);
+    } else if (n >= 3 && strcmp(cmd, "press") == 0 && a < NUM_BANK0_GPIOS) {
+      sim_add_action(t, ACT_GPIO, a, 0);
+      sim_add_action(t + b * 1000000ull, ACT_GPIO, a, 1);
+    } else {
+      fprintf(stderr, "sim: %s:%u: ação inválida\n", path, lineno);
+      exit(2);
+    }
+  }
+  fclose(f);
+}
+
+// ---------------------------------------------------------------- reprodução
+
+static int sim_base64_digit(char c) {
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A';
+  if (c >= 'a' && c <= 'z')
+    return c - 'a' + 26;
+  if (c >= '0' && c <= '9')
+    return c - '0' + 52;
+  return c == '+' ? 62 : c == '/' ? 63 : -1;
+}
+
+static size_t sim_base64_decode(const char *text, uint8_t *out, size_t max) {
+  size_t n = 0;
+  uint32_t acc = 0;
+  unsigned bits = 0;
+  for (; *text && n < max; ++text) {
+    int d = sim_base64_digit(*text);
+    if (d < 0)
+      break; // '=', fim de linha
+    acc = acc << 6 | d;
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out[n++] = acc >> bits;
+    }
+  }
+  return n;
+}
+
+static bool sim_varint(const uint8_t **p, const uint8_t *end, uint32_t *v) {
+  *v = 0;
+  for (unsigned shift = 0; *p < end && shift < 35; shift += 7) {
+    uint8_t b = *(*p)++;
+    *v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80))
+      return true;
+  }
+  return false;
+}
+
+static bool sim_zigzag(const uint8_t **p, const uint8_t *end, int32_t *v) {
+  uint32_t u;
+  if (!sim_varint(p, end, &u))
+    return false;
+  *v = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+  return true;
+}
+
+// Transforma uma gravação do firmware (linhas "trace,<base64>" de trace.h,
+// misturadas a qualquer outra saída) em ações: as leituras dos eixos viram
+// valores dos canais 0 e 1 do ADC e as bordas, níveis impostos aos pinos.
+// Os instantes de 32 bits são desdobrados em 64 para capturas longas.
+static void sim_load_replay(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "sim: gravação %s não encontrada\n", path);
+    exit(2);
+  }
+  char line[1024];
+  uint8_t bin[sizeof(line)];
+  unsigned lineno = 0, records = 0;
+  uint64_t base_us = 0;
+  uint32_t last_us = 0;
+  bool first = true;
+  while (fgets(line, sizeof(line), f)) {
+    ++lineno;
+    if (strncmp(line, "trace,", 6) != 0)
+      continue;
+    size_t len = sim_base64_decode(line + 6, bin, sizeof(bin));
+    const uint8_t *p = bin, *end = bin + len;
+    if (len == 0 || *p++ != TRACE_VERSION) {
+      fprintf(stderr, "sim: %s:%u: gravação em formato desconhecido\n", path, lineno);
+      exit(2);
+    }
+    uint32_t t = 0;
+    int32_t x = 0, y = 0;
+    bool first_in_line = true;
+    while (p < end) {
+      uint8_t type = *p++;
+      uint32_t dt;
+      bool ok = sim_varint(&p, end, &dt);
+      t = first_in_line ? dt : t + dt;
+      first_in_line = false;
+      if (!first && t < last_us && last_us - t > 0x80000000u)
+        base_us += 1ull << 32; // time_us_32 deu a volta
+      first = false;
+      last_us = t;
+      uint64_t at_ns = (base_us + t) * 1000;
+      if (ok && type == TRACE_ADC) {
+        int32_t dx, dy;
+        ok = sim_zigzag(&p, end, &dx) && sim_zigzag(&p, end, &dy);
+        x += dx;
+        y += dy;
+        if (ok && x >= 0 && x <= 4095 && y >= 0 && y <= 4095) {
+          sim_add_action(at_ns, ACT_ADC, 0, x);
+          sim_add_action(at_ns, ACT_ADC, 1, y);
+        } else {
+          ok = false;
+        }
+      } else if (ok && type == TRACE_GPIO && p < end) {
+        uint8_t pin = *p++;
+        ok = (pin & 0x7F) < NUM_BANK0_GPIOS;
+        if (ok)
+          sim_add_action(at_ns, ACT_GPIO, pin & 0x7F, pin >> 7);
+      } else {
+        ok = false;
+      }
+      if (!ok) {
+        fprintf(stderr, "sim: %s:%u: registro inválido\n", path, lineno);
+        exit(2);
+      }
+      ++records;
+    }
+  }
+  fclose(f);
+  fprintf(stderr, "sim: reprodução de %s: %u registros\n", path, records);
+}
+
+static void sim_gpio_report(FILE *out) {
+  fprintf(out, "sim: gpio bordas=%llu adc leituras=%llu\n",
+          (unsigned long long)gpio_edges, (unsigned long long)adc_reads);
+}
+
+void sim_gpio_start(void) {
+  if (sim_opt.script)
+    sim_load_script(sim_opt.script);
+  if (sim_opt.replay)
+    sim_load_replay(sim_opt.replay);
+  if (n_actions > 0)
+    sim_schedule_ns(actions[0].at_ns, sim_run_actions, NULL);
+  sim_add_report(sim_gpio_report);
+  sim_dma_register_endpoint(&(sim_dma_endpoint_t){
+    .reg = &adc_hw->fifo,
+    .transfer = adc_dma_transfer,
+  });
+}
@@ -0,0 +1,501 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "hardware/i2c.h"
+
+// Modelo do SSD1306: GDDRAM de 128x64, endereçamento horizontal, vertical e
+// por página, e os comandos que alteram a imagem visível.
+//
+// Falhas injetadas com --i2c-fault TIPO:BUS:ADDR:INICIO_MS:DURACAO_MS:
+//
+//   nack   o painel some do barramento (NACK no endereço, tela apagada) e volta
+//          ao fim como se tivesse sido religado: desligado e com lixo na GDDRAM
+//   stuck  o painel segura SDA em baixo a partir de INICIO: as transações não
+//          terminam até que pulsos de SCL o soltem, o que só funciona depois
+//          de DURACAO
+//
+// As falhas valem a partir da transação seguinte; uma transferência por DMA
+// já em andamento termina normalmente.
+
+#define BUS_HUNG_NS (1ull << 62) // SDA preso: a transferência não termina
+#define BUS_TX_FIFO_WORDS 16     // IC_TX_BUFFER_DEPTH: o DMA termina com isso ainda na FIFO
+
+typedef struct {
+  uint8_t bus, address;
+  uint8_t gddram[8][128];
+  // Estado do analisador de bytes
+  bool expect_control, co, dc;
+  uint8_t cmd[8], cmd_len, cmd_need;
+  // Ponteiros de endereço
+  uint8_t mode, col, page, col_start, col_end, page_start, page_end;
+  bool display_on, inverted, entire_on;
+  bool absent; // Falha nack em andamento
+  uint8_t mux, contrast;
+  // Captura
+  uint8_t visible[8][128];
+  uint64_t frames, hash, data_bytes, command_bytes;
+  FILE *log;
+} sim_oled_t;
+
+typedef struct {
+  i2c_inst_t *inst;
+  uint baudrate;
+  uint64_t transactions, bytes, nacks, busy_ns;
+  uint64_t collisions; // Escritas iniciadas com um DMA ainda transmitindo no controlador
+  uint64_t timeouts, aborts, releases;
+  bool sda_held;
+  uint64_t hold_until_ns; // Antes disso, pulsos de SCL não soltam SDA
+  // Palavras de IC_DATA_CMD entregues pelo DMA, aplicadas quando a FIFO esvazia
+  uint16_t *pending;
+  size_t pending_len, pending_cap;
+  uint64_t drain_ns; // Da última palavra entregue pelo DMA até a FIFO esvaziar
+} sim_bus_t;
+
+static i2c_hw_t i2c_regs[2];
+i2c_inst_t i2c0_inst = {&i2c_regs[0], false};
+i2c_inst_t i2c1_inst = {&i2c_regs[1], false};
+
+static sim_bus_t buses[2] = {{.inst = &i2c0_inst}, {.inst = &i2c1_inst}};
+static sim_oled_t oleds[SIM_MAX_OLEDS];
+static unsigned n_oleds;
+
+// ---------------------------------------------------------------- SSD1306
+
+static uint8_t oled_arg_count(uint8_t cmd) {
+  switch (cmd) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+      return 1;
+    case 0x21: case 0x22: case 0xA3:
+      return 2;
+    case 0x29: case 0x2A:
+      return 5;
+    case 0x26: case 0x27:
+      return 6;
+    default:
+      return 0;
+  }
+}
+
+static void oled_reset(sim_oled_t *o) {
+  // A GDDRAM liga com lixo: um padrão fixo denuncia quem não envia o quadro inteiro
+  uint32_t x = 0x1234567u ^ o->address;
+  for (unsigned p = 0; p < 8; ++p) {
+    for (unsigned c = 0; c < 128; ++c) {
+      x = x * 1103515245u + 12345u;
+      o->gddram[p][c] = x >> 16;
+    }
+  }
+  o->mode = 2;
+  o->col = o->page = 0;
+  o->col_start = 0;
+  o->col_end = 127;
+  o->page_start = 0;
+  o->page_end = 7;
+  o->display_on = o->inverted = o->entire_on = false;
+  o->mux = 63;
+  o->contrast = 0x7F;
+  o->expect_control = true;
+  o->cmd_need = o->cmd_len = 0;
+}
+
+static void oled_execute(sim_oled_t *o) {
+  const uint8_t *c = o->cmd;
+  switch (c[0]) {
+    case 0x20: o->mode = c[1] & 3; break;
+    case 0x21:
+      o->col_start = o->col = c[1] & 127;
+      o->col_end = c[2] & 127;
+      break;
+    case 0x22:
+      o->page_start = o->page = c[1] & 7;
+      o->page_end = c[2] & 7;
+      break;
+    case 0x81: o->contrast = c[1]; break;
+    case 0xA4: o->entire_on = false; break;
+    case 0xA5: o->entire_on = true; break;
+    case 0xA6: o->inverted = false; break;
+    case 0xA7: o->inverted = true; break;
+    case 0xA8: o->mux = c[1] & 63; break;
+    case 0xAE: o->display_on = false; break;
+    case 0xAF: o->display_on = true; break;
+    default:
+      if (o->mode == 2) {
+        if (c[0] >= 0xB0 && c[0] <= 0xB7)
+          o->page = c[0] & 7;
+        else if (c[0] <= 0x0F)
+          o->col = (o->col & 0xF0) | c[0];
+        else if (c[0] <= 0x1F)
+          o->col = (o->col & 0x0F) | ((c[0] & 0x07) << 4);
+      }
+      break;
+  }
+}
+
+static void oled_command(sim_oled_t *o, uint8_t b) {
+  ++o->command_bytes;
+  if (o->cmd_need == 0) {
+    o->cmd[0] = b;
+    o->cmd_len = 1;
+    o->cmd_need = oled_arg_count(b);
+    if (o->cmd_need == 0)
+      oled_execute(o);
+    return;
+  }
+  o->cmd[o->cmd_len++] = b;
+  if (--o->cmd_need == 0)
+    oled_execute(o);
+}
+
+static void oled_data(sim_oled_t *o, uint8_t b) {
+  ++o->data_bytes;
+  o->gddram[o->page][o->col] = b;
+  switch (o->mode) {
+    case 0: // Horizontal
+      if (o->col == o->col_end) {
+        o->col = o->col_start;
+        o->page = o->page == o->page_end ? o->page_start : o->page + 1;
+      } else {
+        o->col = (o->col + 1) & 127;
+      }
+      break;
+    case 1: // Vertical
+      if (o->page == o->page_end) {
+        o->page = o->page_start;
+        o->col = o->col == o->col_end ? o->col_start : ((o->col + 1) & 127);
+      } else {
+        o->page = (o->page + 1) & 7;
+      }
+      break;
+    default: // Página
+      o->col = o->col == o->col_end ? o->col_start : ((o->col + 1) & 127);
+      break;
+  }
+}
+
+static void oled_begin(sim_oled_t *o) {
+  o->expect_control = true;
+}
+
+static void oled_byte(sim_oled_t *o, uint8_t b) {
+  if (o->expect_control) {
+    o->co = b & 0x80;
+    o->dc = b & 0x40;
+    o->expect_control = false;
+    return;
+  }
+  if (o->dc)
+    oled_data(o, b);
+  else
+    oled_command(o, b);
+  if (o->co)
+    o->expect_control = true;
+}
+
+// Imagem que o painel mostra agora, considerando liga/desliga, inversão e multiplexação
+static void oled_visible(const sim_oled_t *o, uint8_t out[8][128]) {
+  unsigned rows = o->mux + 1u;
+  for (unsigned p = 0; p < 8; ++p) {
+    uint8_t row_mask = p * 8 >= rows ? 0 : (rows - p * 8 >= 8 ? 0xFF : (1u << (rows - p * 8)) - 1);
+    for (unsigned c = 0; c < 128; ++c) {
+      uint8_t v = o->entire_on ? 0xFF : o->gddram[p][c];
+      if (o->inverted)
+        v = ~v;
+      out[p][c] = o->display_on ? (v & row_mask) : 0;
+    }
+  }
+}
+
+static void oled_write_pbm(const sim_oled_t *o, unsigned index) {
+  char name[64];
+  snprintf(name, sizeof(name), "oled%u_%02x_%05u.pbm", o->bus, o->address, index);
+  FILE *f = sim_open_output(name);
+  if (!f)
+    return;
+  unsigned rows = o->mux + 1u;
+  fprintf(f, "P1\n# t=%llu us\n128 %u\n", (unsigned long long)(sim_now_ns() / 1000), rows);
+  for (unsigned y = 0; y < rows; ++y) {
+    for (unsigned x = 0; x < 128; ++x)
+      fputc((o->visible[y >> 3][x] >> (y & 7)) & 1 ? '1' : '0', f);
+    fputc('\n', f);
+  }
+  fclose(f);
+}
+
+// Varredura periódica: cada imagem visível diferente da anterior conta como um quadro
+static void oled_vsync(void *arg) {
+  (void)arg;
+  for (unsigned i = 0; i < n_oleds; ++i) {
+    sim_oled_t *o = &oleds[i];
+    uint8_t now[8][128];
+    oled_visible(o, now);
+    if (o->frames > 0 && memcmp(now, o->visible, sizeof(now)) == 0)
+      continue;
+    memcpy(o->visible, now, sizeof(now));
+    o->hash = sim_hash(o->hash, now, sizeof(now));
+    oled_write_pbm(o, o->frames);
+    if (o->log)
+      fprintf(o->log, "%llu,%llu,%016llx\n", (unsigned long long)o->frames,
+              (unsigned long long)(sim_now_ns() / 1000), (unsigned long long)o->hash);
+    ++o->frames;
+  }
+  sim_schedule_ns(sim_now_ns() + 1000000000ull / sim_opt.vsync_hz, oled_vsync, NULL);
+}
+
+static sim_oled_t *oled_find(unsigned bus, uint8_t address) {
+  for (unsigned i = 0; i < n_oleds; ++i) {
+    if (oleds[i].bus == bus && oleds[i].address == address)
+      return &oleds[i];
+  }
+  return NULL;
+}
+
+// ---------------------------------------------------------------- barramento
+
+// Duração de uma transação: START, endereço, len bytes e STOP, 9 bits por byte
+static uint64_t bus_txn_ns(const sim_bus_t *b, size_t len) {
+  return (uint64_t)((len + 1) * 9 + 2) * 1000000000ull / b->baudrate;
+}
+
+// Retorna false (NACK) se não há painel no endereço ou se o barramento está
+// mais rápido do que o painel tolera
+static bool bus_transaction(sim_bus_t *b, uint8_t address, const uint8_t *data, size_t len) {
+  ++b->transactions;
+  b->bytes += len + 1;
+  b->busy_ns += bus_txn_ns(b, len);
+  sim_oled_t *o = oled_find(b - buses, address);
+  if (!o || o->absent || b->baudrate > sim_opt.oled_max_hz) {
+    ++b->nacks;
+    return false;
+  }
+  oled_begin(o);
+  for (size_t i = 0; i < len; ++i)
+    oled_byte(o, data[i]);
+  return true;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+  i2c->hw->enable = 1;
+  i2c->hw->status = I2C_IC_STATUS_TFE_BITS | I2C_IC_STATUS_TFNF_BITS;
+  i2c->hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS;
+  i2c->restart_on_next = false;
+  return i2c_set_baudrate(i2c, baudrate);
+}
+
+static void bus_drained(void *ctx);
+
+// Desligar o controlador descarta o que estava na FIFO
+void i2c_deinit(i2c_inst_t *i2c) {
+  sim_bus_t *b = &buses[i2c_hw_index(i2c)];
+  i2c->hw->enable = 0;
+  i2c->hw->status = I2C_IC_STATUS_TFE_BITS | I2C_IC_STATUS_TFNF_BITS;
+  i2c->hw->raw_intr_stat = 0;
+  b->pending_len = 0;
+  sim_cancel(bus_drained, b);
+}
+
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate) {
+  // O controlador do RP2040 vai até o Fast-mode Plus
+  if (baudrate > 1000000)
+    baudrate = 1000000;
+  buses[i2c_hw_index(i2c)].baudrate = baudrate;
+  return baudrate;
+}
+
+// A leitura de IC_CLR_TX_ABRT não chega à simulação: o aborto de um envio
+// por DMA vale até a transação seguinte
+static int bus_write(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, uint64_t timeout_ns) {
+  sim_bus_t *b = &buses[i2c_hw_index(i2c)];
+  if (b->pending_len)
+    ++b->collisions;
+  i2c->hw->tar = addr;
+  i2c->hw->raw_intr_stat = 0;
+  uint64_t ns = bus_txn_ns(b, len);
+  if (b->sda_held || ns > timeout_ns) {
+    if (timeout_ns == UINT64_MAX) {
+      fprintf(stderr, "sim: i2c_write_blocking na i2c%u com SDA preso: o firmware travaria aqui\n",
+              i2c_hw_index(i2c));
+      abort();
+    }
+    ++b->timeouts;
+    sim_advance_to_ns(sim_now_ns() + timeout_ns);
+    return PICO_ERROR_TIMEOUT;
+  }
+  bool ack = bus_transaction(b, addr, src, len);
+  sim_advance_to_ns(sim_now_ns() + ns);
+  return ack ? (int)len : PICO_ERROR_GENERIC;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+  (void)nostop;
+  return bus_write(i2c, addr, src, len, UINT64_MAX);
+}
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us) {
+  (void)nostop;
+  return bus_write(i2c, addr, src, len, timeout_us * 1000ull);
+}
+
+bool sim_i2c_sda_held(unsigned bus) {
+  return buses[bus].sda_held;
+}
+
+void sim_i2c_scl_pulse(unsigned bus) {
+  sim_bus_t *b = &buses[bus];
+  if (b->sda_held && sim_now_ns() >= b->hold_until_ns) {
+    b->sda_held = false;
+    ++b->releases;
+  }
+}
+
+// DMA para IC_DATA_CMD: as palavras são guardadas e aplicadas quando a FIFO
+// esvazia; cada STOP encerra uma transação com o endereço em IC_TAR. O DMA
+// termina quando a última palavra entra na FIFO, BUS_TX_FIFO_WORDS palavras
+// antes do fim no barramento, e até lá o controlador segue ativo
+static uint64_t bus_dma_transfer(void *ctx, volatile void *mem, uint32_t count, unsigned size, bool incr) {
+  sim_bus_t *b = ctx;
+  if (size != 2) {
+    // Escritas de 8 ou 32 bits replicam/estendem o byte e acionam CMD/STOP por engano
+    fprintf(stderr, "sim: DMA de %u bytes em IC_DATA_CMD (esperado 16 bits)\n", size);
+    abort();
+  }
+  if (b->pending_len)
+    ++b->collisions;
+  b->inst->hw->raw_intr_stat = 0;
+  if (b->pending_len + count > b->pending_cap) {
+    b->pending_cap = b->pending_len + count;
+    b->pending = realloc(b->pending, b->pending_cap * sizeof(uint16_t));
+  }
+  const volatile uint16_t *src = mem;
+  uint64_t ns = 0;
+  size_t txn_len = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    uint16_t w = src[incr ? i : 0];
+    b->pending[b->pending_len++] = w;
+    ++txn_len;
+    if (w & I2C_IC_DATA_CMD_STOP_BITS) {
+      ns += bus_txn_ns(b, txn_len);
+      txn_len = 0;
+    }
+  }
+  ns += txn_len ? bus_txn_ns(b, txn_len) : 0;
+  b->inst->hw->status = I2C_IC_STATUS_ACTIVITY_BITS | I2C_IC_STATUS_MST_ACTIVITY_BITS | I2C_IC_STATUS_TFNF_BITS;
+  if (b->sda_held) {
+    b->drain_ns = 0;
+    return BUS_HUNG_NS;
+  }
+  b->drain_ns = count ? ns * (count < BUS_TX_FIFO_WORDS ? count : BUS_TX_FIFO_WORDS) / count : 0;
+  return ns - b->drain_ns;
+}
+
+// FIFO vazia: as transações vão ao painel. Um NACK aborta o envio: o
+// controlador descarta o resto da FIFO e sinaliza TX_ABRT
+static void bus_drained(void *ctx) {
+  sim_bus_t *b = ctx;
+  uint8_t txn[2048];
+  size_t len = 0;
+  bool ack = true;
+  uint8_t address = b->inst->hw->tar;
+  for (size_t i = 0; i < b->pending_len && ack; ++i) {
+    if (len < sizeof(txn))
+      txn[len++] = b->pending[i] & 0xFF;
+    if (b->pending[i] & I2C_IC_DATA_CMD_STOP_BITS) {
+      ack = bus_transaction(b, address, txn, len);
+      len = 0;
+    }
+  }
+  if (len && ack)
+    ack = bus_transaction(b, address, txn, len);
+  if (!ack) {
+    ++b->aborts;
+    b->inst->hw->raw_intr_stat = I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+    b->inst->hw->tx_abrt_source = I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS;
+  }
+  b->pending_len = 0;
+  b->inst->hw->status = I2C_IC_STATUS_TFE_BITS | I2C_IC_STATUS_TFNF_BITS;
+}
+
+static void bus_dma_complete(void *ctx) {
+  sim_bus_t *b = ctx;
+  sim_schedule_ns(sim_now_ns() + b->drain_ns, bus_drained, b);
+}
+
+static void sim_i2c_report(FILE *out) {
+  double elapsed = sim_now_ns() ? (double)sim_now_ns() : 1.0;
+  for (unsigned i = 0; i < 2; ++i) {
+    const sim_bus_t *b = &buses[i];
+    if (!b->transactions)
+      continue;
+    fprintf(out, "sim: i2c%u baud=%u transacoes=%llu bytes=%llu nacks=%llu ocupado=%.3f ms (%.1f%%)\n",
+            i, b->baudrate, (unsigned long long)b->transactions, (unsigned long long)b->bytes,
+            (unsigned long long)b->nacks, b->busy_ns / 1e6, 100.0 * b->busy_ns / elapsed);
+    if (b->collisions)
+      fprintf(out, "sim: i2c%u colisoes=%llu (escritas com o DMA do controlador em andamento)\n", i, (unsigned long long)b->collisions);
+    if (b->timeouts || b->aborts || b->releases)
+      fprintf(out, "sim: i2c%u prazos=%llu abortos_dma=%llu sda_liberado=%llu%s\n", i,
+              (unsigned long long)b->timeouts, (unsigned long long)b->aborts, (unsigned long long)b->releases,
+              b->sda_held ? " (SDA ainda preso)" : "");
+  }
+  for (unsigned i = 0; i < n_oleds; ++i) {
+    const sim_oled_t *o = &oleds[i];
+    fprintf(out, "sim: oled i2c%u:0x%02X quadros=%llu dados=%llu comandos=%llu hash=%016llx\n",
+            o->bus, o->address, (unsigned long long)o->frames, (unsigned long long)o->data_bytes,
+            (unsigned long long)o->command_bytes, (unsigned long long)o->hash);
+    if (o->log)
+      fclose(o->log);
+  }
+}
+
+static void fault_begin(void *arg) {
+  const sim_i2c_fault_t *f = arg;
+  sim_oled_t *o = oled_find(f->bus, f->address);
+  if (f->kind == 'n' && o) {
+    o->absent = true;
+    o->display_on = false;
+  } else if (f->kind == 's') {
+    buses[f->bus].sda_held = true;
+    buses[f->bus].hold_until_ns = sim_now_ns() + f->duration_ms * 1000000ull;
+  }
+}
+
+static void fault_end(void *arg) {
+  const sim_i2c_fault_t *f = arg;
+  sim_oled_t *o = oled_find(f->bus, f->address);
+  if (o) {
+    o->absent = false;
+    oled_reset(o);
+  }
+}
+
+void sim_i2c_start(void) {
+  for (unsigned i = 0; i < 2; ++i) {
+    buses[i].inst->hw->status = I2C_IC_STATUS_TFE_BITS | I2C_IC_STATUS_TFNF_BITS;
+    buses[i].baudrate = 100000;
+    sim_dma_register_endpoint(&(sim_dma_endpoint_t){
+      .reg = &buses[i].inst->hw->data_cmd,
+      .transfer = bus_dma_transfer,
+      .complete = bus_dma_complete,
+      .ctx = &buses[i],
+    });
+  }
+  for (unsigned i = 0; i < sim_opt.n_oleds && n_oleds < SIM_MAX_OLEDS; ++i) {
+    sim_oled_t *o = &oleds[n_oleds++];
+    o->bus = sim_opt.oled_bus[i];
+    o->address = sim_opt.oled_addr[i];
+    oled_reset(o);
+    o->hash = SIM_HASH_INIT;
+    char name[64];
+    snprintf(name, sizeof(name), "oled%u_%02x.csv", o->bus, o->address);
+    o->log = sim_open_output(name);
+    if (o->log)
+      fprintf(o->log, "quadro,t_us,hash\n");
+  }
+  for (unsigned i = 0; i < sim_opt.n_i2c_faults; ++i) {
+    sim_i2c_fault_t *f = &sim_opt.i2c_faults[i];
+    sim_schedule_ns(f->start_ms * 1000000ull, fault_begin, f);
+    if (f->kind == 'n')
+      sim_schedule_ns((f->start_ms + f->duration_ms) * 1000000ull, fault_end, f);
+  }
+  sim_schedule_ns(0, oled_vsync, NULL);
+  sim_add_report(sim_i2c_report);
+}
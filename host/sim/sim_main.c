@@ -0,0 +1,10 @@
+#include "sim.h"
+
+// painel.c é compilado com main renomeada para painel_main
+int painel_main(void);
+
+int main(int argc, char **argv) {
+  sim_init(argc, argv);
+  painel_main();
+  return 0;
+}
@@ -0,0 +1,318 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "hardware/pio.h"
+#include "hardware/gpio.h"
+#include "hardware/clocks.h"
+
+// Modelo da máquina de estados rodando o programa ws2818b: cada bit do OSR
+// leva 10 ciclos do PIO e a fita interpreta 24 bits por LED, GRB com o bit
+// mais significativo primeiro. Um intervalo de 50 us sem dados trava o quadro.
+
+#define WS2812_CYCLES_PER_BIT 10
+#define WS2812_RESET_NS 50000
+#define WS2812_MAX_LEDS 256
+#define PIO_INSTRUCTIONS 32
+
+typedef struct {
+  PIO pio;
+  uint sm;
+  bool claimed, enabled;
+  pio_sm_config config;
+  uint pin;
+  uint64_t bit_ns;
+  uint64_t drained_ns; // Instante em que o último bit enfileirado sai do pino
+  // Decodificador da fita
+  uint32_t shift;
+  unsigned nbits, nleds;
+  uint32_t leds[WS2812_MAX_LEDS]; // 0xRRGGBB
+  uint32_t shown[WS2812_MAX_LEDS];
+  unsigned shown_leds;
+  uint64_t words, frames, hash, stalls_ns;
+  unsigned stray_bits;
+  FILE *log;
+} sim_sm_t;
+
+pio_hw_t sim_pio_hw[2];
+
+static sim_sm_t sms[2][NUM_PIO_STATE_MACHINES];
+static uint8_t used_instructions[2];
+static bool report_installed;
+
+static sim_sm_t *sim_sm(PIO pio, uint sm) {
+  return &sms[pio_get_index(pio)][sm];
+}
+
+static unsigned sm_fifo_depth(const sim_sm_t *s) {
+  return s->config.fifo_join == PIO_FIFO_JOIN_TX ? 8 : 4;
+}
+
+static unsigned sm_word_bits(const sim_sm_t *s) {
+  return s->config.pull_threshold ? s->config.pull_threshold : 32;
+}
+
+static uint64_t sm_word_ns(const sim_sm_t *s) {
+  return sm_word_bits(s) * s->bit_ns;
+}
+
+// Palavras ainda na FIFO (a que está no OSR não conta)
+static unsigned sm_fifo_level(const sim_sm_t *s) {
+  uint64_t now = sim_now_ns();
+  if (s->drained_ns <= now)
+    return 0;
+  uint64_t words = (s->drained_ns - now + sm_word_ns(s) - 1) / sm_word_ns(s);
+  return words > 1 ? words - 1 : 0;
+}
+
+// Quadro travado: registra apenas quando difere do que a fita já mostrava
+static void sm_latch(void *arg) {
+  sim_sm_t *s = arg;
+  if (s->nbits)
+    s->stray_bits += s->nbits;
+  s->shift = s->nbits = 0;
+  if (s->nleds == s->shown_leds && memcmp(s->leds, s->shown, s->nleds * sizeof(uint32_t)) == 0) {
+    s->nleds = 0;
+    return;
+  }
+  memcpy(s->shown, s->leds, s->nleds * sizeof(uint32_t));
+  s->shown_leds = s->nleds;
+  s->hash = sim_hash(s->hash, s->shown, s->shown_leds * sizeof(uint32_t));
+  if (s->log) {
+    fprintf(s->log, "%llu,%llu,%016llx", (unsigned long long)s->frames,
+            (unsigned long long)(sim_now_ns() / 1000), (unsigned long long)s->hash);
+    for (unsigned i = 0; i < s->shown_leds; ++i)
+      fprintf(s->log, ",%06x", (unsigned)s->shown[i]);
+    fputc('\n', s->log);
+  }
+  ++s->frames;
+  s->nleds = 0;
+}
+
+static void sm_shift_out(sim_sm_t *s, uint32_t data) {
+  unsigned bits = sm_word_bits(s);
+  for (unsigned i = 0; i < bits; ++i) {
+    bool bit = s->config.out_shift_right ? (data >> i) & 1 : (data >> (31 - i)) & 1;
+    s->shift = (s->shift << 1) | bit;
+    if (++s->nbits == 24) {
+      uint32_t grb = s->shift;
+      if (s->nleds < WS2812_MAX_LEDS)
+        s->leds[s->nleds++] = ((grb & 0x00FF00) << 8) | ((grb & 0xFF0000) >> 8) | (grb & 0xFF);
+      s->shift = s->nbits = 0;
+    }
+  }
+}
+
+// Enfileira uma palavra; o pino fica ocioso se a FIFO esvaziou antes
+static void sm_push(sim_sm_t *s, uint32_t data) {
+  uint64_t now = sim_now_ns();
+  sim_cancel(sm_latch, s);
+  if (s->drained_ns + WS2812_RESET_NS <= now && (s->nleds || s->nbits))
+    sm_latch(s);
+  s->drained_ns = (s->drained_ns > now ? s->drained_ns : now) + sm_word_ns(s);
+  ++s->words;
+  sm_shift_out(s, data);
+  sim_schedule_ns(s->drained_ns + WS2812_RESET_NS, sm_latch, s);
+}
+
+static void sim_pio_report(FILE *out) {
+  for (unsigned p = 0; p < 2; ++p) {
+    for (unsigned i = 0; i < NUM_PIO_STATE_MACHINES; ++i) {
+      const sim_sm_t *s = &sms[p][i];
+      if (!s->words)
+        continue;
+      fprintf(out, "sim: ws2812 pio%u sm%u pino=%u quadros=%llu leds=%u palavras=%llu espera=%.3f ms hash=%016llx\n",
+              p, i, s->pin, (unsigned long long)s->frames, s->shown_leds, (unsigned long long)s->words,
+              s->stalls_ns / 1e6, (unsigned long long)s->hash);
+      if (s->stray_bits)
+        fprintf(out, "sim: ws2812 pio%u sm%u: %u bits sobrando ao travar (quadro incompleto)\n", p, i, s->stray_bits);
+      if (s->log)
+        fclose(s->log);
+    }
+  }
+}
+
+// DMA para a TX FIFO: as palavras entram no ritmo em que a FIFO esvazia
+static uint64_t sm_dma_transfer(void *ctx, volatile void *mem, uint32_t count, unsigned size, bool incr) {
+  sim_sm_t *s = ctx;
+  uint64_t start = sim_now_ns();
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t data;
+    if (size == 4)
+      data = ((const volatile uint32_t *)mem)[incr ? i : 0];
+    else if (size == 2)
+      data = ((const volatile uint16_t *)mem)[incr ? i : 0] * 0x00010001u;
+    else
+      data = ((const volatile uint8_t *)mem)[incr ? i : 0] * 0x01010101u;
+    sm_push(s, data);
+  }
+  // A última palavra entra quando restam depth palavras à frente dela
+  uint64_t fifo_ns = sm_fifo_depth(s) * sm_word_ns(s);
+  return s->drained_ns > start + fifo_ns ? s->drained_ns - fifo_ns - start : 0;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+  unsigned idx = pio_get_index(pio);
+  if (used_instructions[idx] + program->length > PIO_INSTRUCTIONS) {
+    fprintf(stderr, "sim: memória de instruções do pio%u cheia\n", idx);
+    abort();
+  }
+  uint offset = used_instructions[idx];
+  used_instructions[idx] += program->length;
+  return offset;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+  for (uint i = 0; i < NUM_PIO_STATE_MACHINES; ++i) {
+    if (!sim_sm(pio, i)->claimed) {
+      pio_sm_claim(pio, i);
+      return i;
+    }
+  }
+  if (required) {
+    fprintf(stderr, "sim: nenhuma máquina de estados livre no pio%u\n", pio_get_index(pio));
+    abort();
+  }
+  return -1;
+}
+
+void pio_sm_claim(PIO pio, uint sm) {
+  sim_sm(pio, sm)->claimed = true;
+}
+
+void pio_sm_unclaim(PIO pio, uint sm) {
+  sim_sm(pio, sm)->claimed = false;
+}
+
+void pio_gpio_init(PIO pio, uint pin) {
+  gpio_set_function(pin, pio == pio1 ? GPIO_FUNC_PIO1 : GPIO_FUNC_PIO0);
+}
+
+int pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out) {
+  (void)pio;
+  (void)sm;
+  (void)pin_base;
+  (void)pin_count;
+  (void)is_out;
+  return PICO_OK;
+}
+
+pio_sm_config pio_get_default_sm_config(void) {
+  return (pio_sm_config){
+    .clkdiv = 1.0f,
+    .wrap = 31,
+    .out_count = 32,
+    .out_shift_right = true,
+    .pull_threshold = 0,
+  };
+}
+
+void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap) {
+  c->wrap_target = wrap_target;
+  c->wrap = wrap;
+}
+
+void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs) {
+  c->sideset_bit_count = bit_count;
+  c->sideset_optional = optional;
+  c->sideset_pindirs = pindirs;
+}
+
+void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base) {
+  c->sideset_base = sideset_base;
+}
+
+void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count) {
+  c->out_base = out_base;
+  c->out_count = out_count;
+}
+
+void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold) {
+  c->out_shift_right = shift_right;
+  c->autopull = autopull;
+  c->pull_threshold = pull_threshold & 31;
+}
+
+void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join) {
+  c->fifo_join = join;
+}
+
+void sm_config_set_clkdiv(pio_sm_config *c, float div) {
+  c->clkdiv = div;
+}
+
+int pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config) {
+  (void)initial_pc;
+  sim_sm_t *s = sim_sm(pio, sm);
+  unsigned idx = pio_get_index(pio);
+  s->pio = pio;
+  s->sm = sm;
+  s->config = *config;
+  s->pin = config->sideset_base;
+  s->enabled = false;
+  // O divisor fracionário tem resolução de 1/256
+  uint32_t div256 = (uint32_t)(config->clkdiv * 256.0f + 0.5f);
+  s->bit_ns = (uint64_t)WS2812_CYCLES_PER_BIT * div256 * 1000000000ull / 256 / clock_get_hz(clk_sys);
+  if (s->bit_ns == 0)
+    s->bit_ns = 1;
+  s->drained_ns = 0;
+  s->hash = SIM_HASH_INIT;
+  if (!s->log) {
+    char name[32];
+    snprintf(name, sizeof(name), "ws2812_pio%u_sm%u.csv", idx, sm);
+    s->log = sim_open_output(name);
+    if (s->log)
+      fprintf(s->log, "quadro,t_us,hash,leds_rgb\n");
+    sim_dma_register_endpoint(&(sim_dma_endpoint_t){
+      .reg = &pio->txf[sm],
+      .transfer = sm_dma_transfer,
+      .ctx = s,
+    });
+  }
+  if (!report_installed) {
+    sim_add_report(sim_pio_report);
+    report_installed = true;
+  }
+  return PICO_OK;
+}
+
+void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+  sim_sm(pio, sm)->enabled = enabled;
+}
+
+void pio_sm_clear_fifos(PIO pio, uint sm) {
+  sim_sm_t *s = sim_sm(pio, sm);
+  uint64_t now = sim_now_ns();
+  if (s->drained_ns > now + sm_word_ns(s))
+    s->drained_ns = now + sm_word_ns(s);
+}
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data) {
+  sim_sm_t *s = sim_sm(pio, sm);
+  // Escrita com a FIFO cheia é descartada, como no hardware
+  if (sm_fifo_level(s) >= sm_fifo_depth(s))
+    return;
+  sm_push(s, data);
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) {
+  sim_sm_t *s = sim_sm(pio, sm);
+  if (s->enabled && sm_fifo_level(s) >= sm_fifo_depth(s)) {
+    uint64_t free_at = s->drained_ns - sm_fifo_depth(s) * sm_word_ns(s);
+    s->stalls_ns += free_at - sim_now_ns();
+    sim_advance_to_ns(free_at);
+  }
+  sm_push(s, data);
+}
+
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm) {
+  const sim_sm_t *s = sim_sm(pio, sm);
+  return sm_fifo_level(s) >= sm_fifo_depth(s);
+}
+
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm) {
+  return sm_fifo_level(sim_sm(pio, sm)) == 0;
+}
+
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm) {
+  return sm_fifo_level(sim_sm(pio, sm));
+}
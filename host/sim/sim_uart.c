@@ -0,0 +1,160 @@
+#include <stdlib.h>
+#include "sim.h"
+#include "hardware/uart.h"
+#include "ingest.h"
+
+// Recepção das UARTs pelo DMA. Com --vehicle-hz, um controlador simulado
+// envia quadros de dados do veículo (ingest.h) na UART1, no ritmo pedido ou,
+// acima do que a linha comporta, um atrás do outro. Cada byte chega 10 bits
+// depois do anterior; o contador do canal de DMA desce a cada byte que chega
+// e a transferência termina com o último deles. O conteúdo é uma função do
+// instante do quadro:
+//
+//   velocidade  sobe de 0 a 120 km/h em 8 s e desce em outros 8
+//   combustível 9,0 L no início, 0,1 L a menos a cada 100 ms, até zerar
+//   flags       "MM On" entre 6,0 e 6,5 s
+//
+// Com --vehicle-errors N, um a cada N quadros sai com um bit trocado.
+
+#define UART_IDLE_NS (1ull << 62) // Sem transmissor: a transferência não termina
+
+typedef struct {
+  uart_inst_t *inst;
+  bool sender;
+  uint8_t frame[INGEST_FRAME_MAX];
+  unsigned len, pos;
+  uint64_t start_ns;     // Instante em que a UART foi iniciada
+  uint64_t frame_ns;     // Início do quadro atual
+  uint64_t line_free_ns; // Fim do último byte do quadro atual
+  uint64_t *arrival_ns;  // Chegada de cada byte da transferência de DMA em curso
+  uint32_t arrivals, arrival_cap;
+  uint64_t frames, bytes, corrupted;
+} sim_uart_t;
+
+static uart_hw_t uart_regs[2];
+uart_inst_t uart0_inst = {&uart_regs[0], 0};
+uart_inst_t uart1_inst = {&uart_regs[1], 0};
+
+static sim_uart_t uarts[2] = {{.inst = &uart0_inst}, {.inst = &uart1_inst, .sender = true}};
+
+uint uart_init(uart_inst_t *uart, uint baudrate) {
+  sim_uart_t *u = &uarts[uart_get_index(uart)];
+  uart->hw->cr = 1;
+  uart->hw->dmacr = UART_UARTDMACR_TXDMAE_BITS | UART_UARTDMACR_RXDMAE_BITS;
+  u->start_ns = u->line_free_ns = sim_now_ns();
+  u->len = u->pos = 0;
+  return uart_set_baudrate(uart, baudrate);
+}
+
+void uart_deinit(uart_inst_t *uart) {
+  uart->hw->cr = 0;
+  uart->hw->dmacr = 0;
+}
+
+uint uart_set_baudrate(uart_inst_t *uart, uint baudrate) {
+  uart->baudrate = baudrate;
+  return baudrate;
+}
+
+void uart_set_format(uart_inst_t *uart, uint data_bits, uint stop_bits, uart_parity_t parity) {
+  (void)uart;
+  (void)data_bits;
+  (void)stop_bits;
+  (void)parity;
+}
+
+void uart_set_fifo_enabled(uart_inst_t *uart, bool enabled) {
+  (void)uart;
+  (void)enabled;
+}
+
+static uint64_t uart_byte_ns(const sim_uart_t *u) {
+  return 10000000000ull / (u->inst->baudrate ? u->inst->baudrate : 115200);
+}
+
+// Próximo quadro do controlador simulado
+static void vehicle_frame(sim_uart_t *u) {
+  uint64_t due = u->start_ns + u->frames * (1000000000ull / sim_opt.vehicle_hz);
+  u->frame_ns = due > u->line_free_ns ? due : u->line_free_ns;
+  uint32_t t_ms = (u->frame_ns - u->start_ns) / 1000000;
+  uint32_t phase = t_ms % 16000;
+  uint16_t speed = (phase < 8000 ? phase : 16000 - phase) * 1200 / 8000;
+  uint16_t fuel = t_ms < 9000 ? 90 - t_ms / 100 : 0;
+  uint8_t flags = t_ms >= 6000 && t_ms < 6500 ? INGEST_FLAG_MM : 0;
+  u->len = ingest_encode(u->frame, u->frames, speed, fuel, flags);
+  u->pos = 0;
+  if (sim_opt.vehicle_errors && (u->frames + 1) % sim_opt.vehicle_errors == 0) {
+    u->frame[INGEST_HEADER_BYTES + u->frames % INGEST_PAYLOAD_MIN] ^= 0x10;
+    ++u->corrupted;
+  }
+  u->line_free_ns = u->frame_ns + u->len * uart_byte_ns(u);
+  ++u->frames;
+}
+
+// O DMA lê dr: os bytes são entregues já, e a transferência dura até o
+// último deles chegar pela linha
+static uint64_t uart_dma_transfer(void *ctx, volatile void *mem, uint32_t count, unsigned size, bool incr) {
+  sim_uart_t *u = ctx;
+  if (!(u->inst->hw->dmacr & UART_UARTDMACR_RXDMAE_BITS)) {
+    fprintf(stderr, "sim: DMA lendo a UART%u sem DREQ habilitado\n", uart_get_index(u->inst));
+    abort();
+  }
+  if (count > u->arrival_cap) {
+    u->arrival_ns = realloc(u->arrival_ns, count * sizeof *u->arrival_ns);
+    u->arrival_cap = count;
+  }
+  u->arrivals = count;
+  if (!u->sender || !sim_opt.vehicle_hz) {
+    for (uint32_t i = 0; i < count; ++i)
+      u->arrival_ns[i] = UART_IDLE_NS;
+    return UART_IDLE_NS;
+  }
+  uint64_t now = sim_now_ns(), last_ns = now;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (u->pos == u->len)
+      vehicle_frame(u);
+    last_ns = u->frame_ns + (u->pos + 1) * uart_byte_ns(u);
+    u->arrival_ns[i] = last_ns;
+    uint8_t byte = u->frame[u->pos++];
+    if (size == 1)
+      ((volatile uint8_t *)mem)[incr ? i : 0] = byte;
+    else if (size == 2)
+      ((volatile uint16_t *)mem)[incr ? i : 0] = byte;
+    else
+      ((volatile uint32_t *)mem)[incr ? i : 0] = byte;
+  }
+  u->bytes += count;
+  return last_ns > now ? last_ns - now : 0;
+}
+
+// Bytes da transferência em curso que ainda não chegaram pela linha
+static uint32_t uart_dma_remaining(void *ctx) {
+  const sim_uart_t *u = ctx;
+  uint64_t now = sim_now_ns();
+  uint32_t left = 0;
+  while (left < u->arrivals && u->arrival_ns[u->arrivals - 1 - left] > now)
+    ++left;
+  return left;
+}
+
+static void sim_uart_report(FILE *out) {
+  for (unsigned i = 0; i < 2; ++i) {
+    const sim_uart_t *u = &uarts[i];
+    if (!u->frames)
+      continue;
+    fprintf(out, "sim: uart%u baud=%u quadros=%llu bytes=%llu corrompidos=%llu\n", i, u->inst->baudrate,
+            (unsigned long long)u->frames, (unsigned long long)u->bytes, (unsigned long long)u->corrupted);
+  }
+}
+
+void sim_uart_start(void) {
+  for (unsigned i = 0; i < 2; ++i) {
+    sim_dma_register_endpoint(&(sim_dma_endpoint_t){
+      .reg = &uarts[i].inst->hw->dr,
+      .transfer = uart_dma_transfer,
+      .remaining = uart_dma_remaining,
+      .ctx = &uarts[i],
+    });
+  }
+  sim_add_report(sim_uart_report);
+}
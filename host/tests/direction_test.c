@@ -0,0 +1,122 @@
+#include <math.h>
+#include <stdio.h>
+#include "direction.h"
+#include "joystick.h"
+
+// Teste de direction.c contra uma referência em ponto flutuante (atan2 e
+// hypot) em toda a grade de 12 bits dos eixos, convertida como em
+// joystick_read com a calibração padrão. As tabelas erram o ângulo em até
+// ~4/65536 de volta e o módulo em pouco mais de uma unidade: a menos dessas
+// margens de uma fronteira (de setor, da zona morta ou da histerese), o
+// resultado tem de ser exatamente o da referência.
+
+#define ANGLE_TOL 8 // 1/65536 de volta
+#define MAG_TOL 2
+#define MAX_REPORTS 10
+
+static const direction_config_t configs[] = {
+  {.deadzone = 200, .radial_hysteresis = 50, .angular_hysteresis = 512, .sectors = 8}, // A do painel
+  {.deadzone = 150, .radial_hysteresis = 40, .angular_hysteresis = 1024, .sectors = 16},
+};
+
+static unsigned failures;
+
+static int16_t scale(uint32_t raw) {
+  return raw < 2048 ? ((int32_t)raw - 2048) * JOYSTICK_FULL_SCALE / 2048
+                    : ((int32_t)raw - 2048) * JOYSTICK_FULL_SCALE / 2047;
+}
+
+static void fail(const direction_config_t *config, const char *check, int16_t x, int16_t y, unsigned got,
+                 unsigned expected) {
+  if (failures++ < MAX_REPORTS)
+    fprintf(stderr, "%u setores, %s: (%d, %d) deu %u, esperado %u\n", config->sectors, check, x, y, got,
+            expected);
+}
+
+// Setor vizinho do lado positivo (step 1) ou negativo (step -1)
+static uint8_t neighbour(const direction_config_t *config, uint8_t sector, int step) {
+  return (sector + config->sectors + step) % config->sectors;
+}
+
+// Leva o classificador ao setor dado, com uma leitura no meio dele
+static void prime(direction_classifier_t *c, uint8_t sector) {
+  double a = sector * 2 * M_PI / c->config.sectors;
+  direction_reset(c);
+  direction_classify(c, (int16_t)lround(900 * cos(a)), (int16_t)lround(900 * sin(a)));
+}
+
+static void check_config(const direction_config_t *config) {
+  direction_classifier_t c;
+  direction_init(&c, config);
+  double width = (double)DIRECTION_TURN / config->sectors;
+  double leave = config->deadzone + config->radial_hysteresis;
+
+  for (uint32_t raw_y = 0; raw_y < 4096; ++raw_y) {
+    int16_t y = scale(raw_y);
+    for (uint32_t raw_x = 0; raw_x < 4096; ++raw_x) {
+      int16_t x = scale(raw_x);
+      double mag = hypot(x, y);
+      double angle = atan2(y, x) * DIRECTION_TURN / (2 * M_PI);
+      if (angle < 0)
+        angle += DIRECTION_TURN;
+      // Setor de referência e quanto o ângulo passou da fronteira mais próxima
+      double pos = fmod(angle + width / 2, DIRECTION_TURN);
+      uint8_t sector = (uint8_t)(pos / width);
+      double into = fmod(pos, width);
+      int side = into < width / 2 ? -1 : 1;
+      double past = side < 0 ? into : width - into;
+
+      // Sem histerese: ângulo e módulo, zona morta com a margem de saída do
+      // centro, e setor
+      direction_reset(&c);
+      direction_t d = direction_classify(&c, x, y);
+      double error = fmod(d.angle - angle + 1.5 * DIRECTION_TURN, DIRECTION_TURN) - DIRECTION_TURN / 2;
+      if ((x || y) && fabs(error) > ANGLE_TOL)
+        fail(config, "ângulo", x, y, d.angle, (unsigned)lround(angle) % DIRECTION_TURN);
+      if (fabs(d.magnitude - mag) > MAG_TOL)
+        fail(config, "módulo", x, y, d.magnitude, (unsigned)lround(mag));
+      if (mag < leave - MAG_TOL && d.sector != DIRECTION_CENTER)
+        fail(config, "zona morta", x, y, d.sector, DIRECTION_CENTER);
+      if (mag > leave + MAG_TOL) {
+        bool near = past < ANGLE_TOL && d.sector == neighbour(config, sector, side);
+        if (d.sector != sector && !near)
+          fail(config, "setor", x, y, d.sector, sector);
+      }
+
+      // Histerese radial: fora do centro, só a zona morta leva de volta a ele
+      if (mag > config->deadzone + MAG_TOL && mag < leave - MAG_TOL) {
+        prime(&c, sector);
+        d = direction_classify(&c, x, y);
+        if (d.sector != sector)
+          fail(config, "histerese radial", x, y, d.sector, sector);
+      } else if (mag < config->deadzone - MAG_TOL) {
+        prime(&c, sector);
+        d = direction_classify(&c, x, y);
+        if (d.sector != DIRECTION_CENTER)
+          fail(config, "zona morta com histerese", x, y, d.sector, DIRECTION_CENTER);
+      }
+
+      // Histerese angular: vindo do vizinho do outro lado da fronteira, o
+      // setor só muda depois de angular_hysteresis além dela
+      if (mag > leave + MAG_TOL) {
+        uint8_t previous = neighbour(config, sector, side);
+        prime(&c, previous);
+        d = direction_classify(&c, x, y);
+        if (past < config->angular_hysteresis - ANGLE_TOL && d.sector != previous)
+          fail(config, "histerese angular", x, y, d.sector, previous);
+        if (past > config->angular_hysteresis + ANGLE_TOL && d.sector != sector)
+          fail(config, "fim da histerese angular", x, y, d.sector, sector);
+      }
+    }
+  }
+}
+
+int main(void) {
+  for (unsigned i = 0; i < sizeof(configs) / sizeof(configs[0]); ++i)
+    check_config(&configs[i]);
+  if (failures) {
+    fprintf(stderr, "%u falhas\n", failures);
+    return 1;
+  }
+  return 0;
+}
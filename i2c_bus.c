@@ -0,0 +1,150 @@
+#include "i2c_bus.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+
+typedef struct {
+  uint sda_pin, scl_pin;
+  uint baudrate;
+  i2c_bus_stats_t stats;
+} i2c_bus_t;
+
+static i2c_bus_t buses[2];
+
+static inline i2c_bus_t *bus_of(i2c_inst_t *i2c) {
+  return &buses[i2c_hw_index(i2c)];
+}
+
+void i2c_bus_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin, uint baudrate) {
+  i2c_bus_t *b = bus_of(i2c);
+  b->sda_pin = sda_pin;
+  b->scl_pin = scl_pin;
+  b->baudrate = i2c_init(i2c, baudrate);
+  gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+  gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+  gpio_pull_up(sda_pin);
+  gpio_pull_up(scl_pin);
+}
+
+uint i2c_bus_set_baudrate(i2c_inst_t *i2c, uint baudrate) {
+  return bus_of(i2c)->baudrate = i2c_set_baudrate(i2c, baudrate);
+}
+
+// Prazo de uma transação de len bytes: o dobro do tempo de linha (endereço e
+// 9 bits por byte, mais START e STOP), para clock stretching, mais a folga
+uint32_t i2c_bus_timeout_us(i2c_inst_t *i2c, size_t len) {
+  uint64_t bits = (len + 1) * 9 + 2;
+  return bits * 2000000u / bus_of(i2c)->baudrate + I2C_BUS_MARGIN_US;
+}
+
+// Também da interrupção (prazo de um envio por DMA)
+void i2c_bus_record(i2c_inst_t *i2c, i2c_bus_status_t status, uint32_t us) {
+  i2c_bus_stats_t *s = &bus_of(i2c)->stats;
+  uint32_t irq = save_and_disable_interrupts();
+  ++s->transactions;
+  if (status == I2C_BUS_NACK_ADDRESS || status == I2C_BUS_NACK_DATA)
+    ++s->nacks;
+  else if (status == I2C_BUS_TIMEOUT)
+    ++s->timeouts;
+  if (us > s->max_us)
+    s->max_us = us;
+  restore_interrupts(irq);
+}
+
+// Fim de um envio por DMA, na interrupção: só ela escreve estes campos
+void i2c_bus_record_dma(i2c_inst_t *i2c, uint32_t us) {
+  i2c_bus_stats_t *s = &bus_of(i2c)->stats;
+  ++s->dma_transfers;
+  if (us > s->max_dma_us)
+    s->max_dma_us = us;
+}
+
+// Resultado de i2c_write_timeout_us: com o endereço aceito e um byte recusado
+// o SDK retorna quantos bytes foram antes dele
+static i2c_bus_status_t i2c_bus_classify(int result, size_t len) {
+  if (result == (int)len)
+    return I2C_BUS_OK;
+  if (result == PICO_ERROR_TIMEOUT)
+    return I2C_BUS_TIMEOUT;
+  if (result >= 0)
+    return I2C_BUS_NACK_DATA;
+  return I2C_BUS_NACK_ADDRESS;
+}
+
+// Escreve len bytes em address, com prazo por tentativa. Endereço sem
+// resposta não é repetido: é um painel ausente ou desligado, que quem chama
+// trata (ssd1306 reconfigura mais tarde); NACK nos dados e prazo estourado
+// são repetidos até I2C_BUS_RETRIES vezes, o prazo depois de liberar o
+// barramento
+i2c_bus_status_t i2c_bus_write(i2c_inst_t *i2c, uint8_t address, const uint8_t *src, size_t len) {
+  i2c_bus_t *b = bus_of(i2c);
+  i2c_bus_status_t status;
+  for (uint attempt = 0;; ++attempt) {
+    uint32_t start = time_us_32();
+    int result = i2c_write_timeout_us(i2c, address, src, len, false, i2c_bus_timeout_us(i2c, len));
+    status = i2c_bus_classify(result, len);
+    i2c_bus_record(i2c, status, time_us_32() - start);
+    if (status == I2C_BUS_OK || status == I2C_BUS_NACK_ADDRESS || attempt == I2C_BUS_RETRIES)
+      break;
+    ++b->stats.retries;
+    if (status == I2C_BUS_TIMEOUT && !i2c_bus_recover(i2c)) {
+      status = I2C_BUS_STUCK;
+      break;
+    }
+  }
+  return status;
+}
+
+// Classifica e limpa o aborto deixado por um envio por DMA. Depois de um NACK
+// o controlador descarta o resto da FIFO até a leitura de IC_CLR_TX_ABRT, então
+// é preciso chamar antes do próximo envio. Também da interrupção
+i2c_bus_status_t i2c_bus_take_abort(i2c_inst_t *i2c) {
+  i2c_hw_t *hw = i2c_get_hw(i2c);
+  if (!(hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS))
+    return I2C_BUS_OK;
+  uint32_t source = hw->tx_abrt_source;
+  (void)hw->clr_tx_abrt;
+  uint32_t irq = save_and_disable_interrupts();
+  ++bus_of(i2c)->stats.nacks;
+  restore_interrupts(irq);
+  return source & I2C_IC_TX_ABRT_SOURCE_ABRT_TXDATA_NOACK_BITS ? I2C_BUS_NACK_DATA : I2C_BUS_NACK_ADDRESS;
+}
+
+// Libera um barramento preso: com o controlador desligado, SCL pulsa (dreno
+// aberto: saída em 0 ou entrada com pull-up) até o escravo soltar SDA, no
+// máximo um byte e o ACK, e um STOP encerra a transação que ele achava em
+// andamento. O controlador volta na mesma frequência. Retorna falso se SDA
+// continuar em baixo. Também da interrupção: leva uns 100 us
+bool i2c_bus_recover(i2c_inst_t *i2c) {
+  i2c_bus_t *b = bus_of(i2c);
+  i2c_deinit(i2c);
+  gpio_init(b->sda_pin);
+  gpio_init(b->scl_pin);
+  for (uint i = 0; i < I2C_BUS_RECOVERY_CLOCKS && !gpio_get(b->sda_pin); ++i) {
+    gpio_set_dir(b->scl_pin, GPIO_OUT);
+    busy_wait_us_32(I2C_BUS_RECOVERY_HALF_US);
+    gpio_set_dir(b->scl_pin, GPIO_IN);
+    busy_wait_us_32(I2C_BUS_RECOVERY_HALF_US);
+  }
+  bool released = gpio_get(b->sda_pin);
+  if (released) {
+    // STOP: SDA sobe com SCL em alto
+    gpio_set_dir(b->sda_pin, GPIO_OUT);
+    busy_wait_us_32(I2C_BUS_RECOVERY_HALF_US);
+    gpio_set_dir(b->sda_pin, GPIO_IN);
+    busy_wait_us_32(I2C_BUS_RECOVERY_HALF_US);
+  }
+  i2c_init(i2c, b->baudrate);
+  gpio_set_function(b->sda_pin, GPIO_FUNC_I2C);
+  gpio_set_function(b->scl_pin, GPIO_FUNC_I2C);
+  uint32_t irq = save_and_disable_interrupts();
+  if (released)
+    ++b->stats.recoveries;
+  else
+    ++b->stats.stuck;
+  restore_interrupts(irq);
+  return released;
+}
+
+const i2c_bus_stats_t *i2c_bus_stats(i2c_inst_t *i2c) {
+  return &bus_of(i2c)->stats;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+// Transporte I2C com prazo. Cada transação bloqueante tem um limite de tempo
+// calculado pelo tamanho e pela frequência do barramento, o erro é
+// classificado e, se o prazo estourar (um escravo segurando SDA em baixo no
+// meio de um byte), o barramento é liberado com pulsos de SCL antes da nova
+// tentativa. Nenhuma função daqui espera mais que o prazo de algumas
+// transações: um painel com defeito atrasa os quadros, não trava quem envia.
+
+#define I2C_BUS_MARGIN_US 1000     // Folga somada ao prazo de cada transação
+#define I2C_BUS_RETRIES 2          // Novas tentativas depois de NACK nos dados ou prazo estourado
+#define I2C_BUS_RECOVERY_CLOCKS 9  // Pulsos de SCL: um byte e o ACK
+#define I2C_BUS_RECOVERY_HALF_US 5 // Meio período de SCL na recuperação (100 kHz)
+
+typedef enum {
+  I2C_BUS_OK = 0,
+  I2C_BUS_NACK_ADDRESS, // Ninguém respondeu no endereço
+  I2C_BUS_NACK_DATA,    // O escravo recusou um byte no meio da transação
+  I2C_BUS_TIMEOUT,      // A transação não terminou no prazo
+  I2C_BUS_STUCK,        // SDA continua em baixo depois da recuperação
+} i2c_bus_status_t;
+
+typedef struct {
+  uint32_t transactions; // Transações bloqueantes, incluindo as repetidas
+  uint32_t nacks;        // Endereço ou dados recusados, também nos envios por DMA
+  uint32_t timeouts;     // Prazos estourados, também nos envios por DMA
+  uint32_t retries;
+  uint32_t recoveries;   // Barramento liberado com pulsos de SCL
+  uint32_t stuck;        // Recuperações em que SDA não voltou
+  uint32_t max_us;       // Transação bloqueante (ou envio abortado) mais longa
+  uint32_t dma_transfers;
+  uint32_t max_dma_us;   // Envio por DMA mais longo, do início ao último byte na FIFO
+} i2c_bus_stats_t;
+
+void i2c_bus_init(i2c_inst_t *i2c, uint sda_pin, uint scl_pin, uint baudrate);
+uint i2c_bus_set_baudrate(i2c_inst_t *i2c, uint baudrate);
+uint32_t i2c_bus_timeout_us(i2c_inst_t *i2c, size_t len);
+i2c_bus_status_t i2c_bus_write(i2c_inst_t *i2c, uint8_t address, const uint8_t *src, size_t len);
+i2c_bus_status_t i2c_bus_take_abort(i2c_inst_t *i2c);
+bool i2c_bus_recover(i2c_inst_t *i2c);
+void i2c_bus_record(i2c_inst_t *i2c, i2c_bus_status_t status, uint32_t us);
+void i2c_bus_record_dma(i2c_inst_t *i2c, uint32_t us);
+const i2c_bus_stats_t *i2c_bus_stats(i2c_inst_t *i2c);
@@ -0,0 +1,215 @@
+#include "ingest.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+#define INGEST_RING_SIZE (1u << INGEST_RING_BITS)
+#define INGEST_BLOCKS (INGEST_RING_SIZE / INGEST_BLOCK_BYTES)
+
+// CRC-16/CCITT meio byte por vez: 32 bytes de tabela na flash
+static const uint16_t crc_nibble[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+  0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+};
+
+static inline uint16_t crc_update(uint16_t crc, uint8_t byte) {
+  crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (byte >> 4)];
+  crc = (crc << 4) ^ crc_nibble[(crc >> 12) ^ (byte & 0x0F)];
+  return crc;
+}
+
+uint16_t ingest_crc16(const uint8_t *data, uint len) {
+  uint16_t crc = 0xFFFF;
+  for (uint i = 0; i < len; ++i)
+    crc = crc_update(crc, data[i]);
+  return crc;
+}
+
+// Monta um quadro com o payload mínimo; retorna o tamanho em bytes
+uint ingest_encode(uint8_t *frame, uint8_t seq, uint16_t speed, uint16_t fuel, uint8_t flags) {
+  frame[0] = INGEST_SYNC0;
+  frame[1] = INGEST_SYNC1;
+  frame[2] = INGEST_PAYLOAD_MIN;
+  frame[3] = seq;
+  frame[4] = speed;
+  frame[5] = speed >> 8;
+  frame[6] = fuel;
+  frame[7] = fuel >> 8;
+  frame[8] = flags;
+  uint16_t crc = ingest_crc16(frame + 2, INGEST_PAYLOAD_MIN + 2);
+  frame[9] = crc;
+  frame[10] = crc >> 8;
+  return INGEST_HEADER_BYTES + INGEST_PAYLOAD_MIN + INGEST_CRC_BYTES;
+}
+
+// ---------------------------------------------------------------- análise
+
+// window: bytes antes de head que o DMA ainda não pode ter sobrescrito
+void ingest_parser_init(ingest_parser_t *p, const uint8_t *ring, uint32_t size, uint32_t window) {
+  *p = (ingest_parser_t){
+    .ring = ring,
+    .mask = size - 1,
+    .window = window,
+  };
+}
+
+static inline uint16_t ring_u16(const uint8_t *ring, uint32_t mask, uint32_t i) {
+  return ring[i & mask] | ring[(i + 1) & mask] << 8;
+}
+
+// Analisa os bytes de tail até head, onde estão, e publica o último quadro
+// válido. Um quadro incompleto fica para a próxima chamada; com sincronismo,
+// tamanho ou CRC errados o analisador avança um byte e procura de novo.
+// Retorna o número de quadros aceitos
+uint32_t ingest_parse(ingest_parser_t *p, uint32_t head, uint32_t t_us) {
+  const uint8_t *ring = p->ring;
+  uint32_t mask = p->mask;
+  uint32_t tail = p->tail;
+  if (head - tail > p->window) {
+    // Os bytes pendentes já podem ter sido sobrescritos: recomeça do que chegou
+    ++p->stats.overruns;
+    tail = head;
+  }
+
+  uint32_t accepted = 0;
+  ingest_values_t v;
+  while (head - tail >= INGEST_HEADER_BYTES + INGEST_PAYLOAD_MIN + INGEST_CRC_BYTES) {
+    uint8_t len = ring[(tail + 2) & mask];
+    if (ring[tail & mask] != INGEST_SYNC0 || ring[(tail + 1) & mask] != INGEST_SYNC1 ||
+        len < INGEST_PAYLOAD_MIN || len > INGEST_PAYLOAD_MAX) {
+      ++tail;
+      ++p->stats.skipped;
+      continue;
+    }
+    uint32_t size = INGEST_HEADER_BYTES + len + INGEST_CRC_BYTES;
+    if (head - tail < size)
+      break;
+    uint16_t crc = 0xFFFF;
+    for (uint32_t i = 2; i < size - INGEST_CRC_BYTES; ++i)
+      crc = crc_update(crc, ring[(tail + i) & mask]);
+    if (crc != ring_u16(ring, mask, tail + size - INGEST_CRC_BYTES)) {
+      ++tail;
+      ++p->stats.crc_errors;
+      continue;
+    }
+
+    uint8_t seq = ring[(tail + 3) & mask];
+    if (p->stats.frames)
+      p->stats.lost += (uint8_t)(seq - p->last_seq - 1);
+    p->last_seq = seq;
+    ++p->stats.frames;
+    ++accepted;
+    v.speed = ring_u16(ring, mask, tail + 4);
+    v.fuel = ring_u16(ring, mask, tail + 6);
+    v.flags = ring[(tail + 8) & mask];
+    v.frame_seq = seq;
+    tail += size;
+  }
+  p->tail = tail;
+
+  if (accepted) {
+    v.seq = p->stats.frames;
+    v.t_us = t_us;
+    p->version = p->version + 1;
+    __dmb();
+    p->latest = v;
+    __dmb();
+    p->version = p->version + 1;
+  }
+  return accepted;
+}
+
+// Cópia consistente dos últimos valores publicados, de qualquer núcleo.
+// Retorna false se nenhum quadro foi aceito ainda
+bool ingest_read(const ingest_parser_t *p, ingest_values_t *out) {
+  uint32_t version;
+  do {
+    version = p->version;
+    __dmb();
+    *out = p->latest;
+    __dmb();
+  } while ((version & 1) || version != p->version);
+  return out->seq != 0;
+}
+
+// ---------------------------------------------------------------- UART e DMA
+
+static uint8_t ring[INGEST_RING_SIZE];
+static int dma_channels[2];
+static uint next_block[2];          // Bloco que cada canal escreve a seguir
+static volatile uint32_t head;      // Bytes recebidos em blocos completos
+static volatile uint32_t head_us;
+static ingest_parser_t parser;
+
+// Fim de um bloco: o outro canal já assumiu a FIFO pelo encadeamento; este é
+// rearmado dois blocos à frente
+static void ingest_dma_irq_handler(void) {
+  for (uint i = 0; i < 2; ++i) {
+    int ch = dma_channels[i];
+    if (dma_channel_get_irq0_status(ch)) {
+      dma_channel_acknowledge_irq0(ch);
+      next_block[i] = (next_block[i] + 2) % INGEST_BLOCKS;
+      dma_channel_set_write_addr(ch, ring + next_block[i] * INGEST_BLOCK_BYTES, false);
+      dma_channel_set_trans_count(ch, INGEST_BLOCK_BYTES, false);
+      head_us = time_us_32();
+      __dmb();
+      head = head + INGEST_BLOCK_BYTES;
+    }
+  }
+}
+
+void ingest_init(const ingest_config_t *config) {
+  // ingest_poll() analisa até a posição de escrita, que pode estar até um
+  // bloco adiante de head; o restante desse bloco e o seguinte, já armado,
+  // ficam fora da janela de análise
+  ingest_parser_init(&parser, ring, INGEST_RING_SIZE, INGEST_RING_SIZE - 3 * INGEST_BLOCK_BYTES);
+
+  uart_init(config->uart, config->baudrate);
+  gpio_set_function(config->rx_pin, GPIO_FUNC_UART);
+
+  dma_channels[0] = dma_claim_unused_channel(true);
+  dma_channels[1] = dma_claim_unused_channel(true);
+  for (uint i = 0; i < 2; ++i) {
+    int ch = dma_channels[i];
+    next_block[i] = i;
+    dma_channel_config c = dma_channel_get_default_config(ch);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, uart_get_dreq(config->uart, false));
+    channel_config_set_chain_to(&c, dma_channels[i ^ 1]);
+    dma_channel_configure(ch, &c, ring + i * INGEST_BLOCK_BYTES, &uart_get_hw(config->uart)->dr,
+                          INGEST_BLOCK_BYTES, false);
+    dma_channel_set_irq0_enabled(ch, true);
+  }
+  irq_add_shared_handler(DMA_IRQ_0, ingest_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_0, true);
+  dma_channel_start(dma_channels[0]);
+}
+
+// Analisa os bytes que chegaram desde a última chamada (núcleo 0, fora da
+// interrupção), incluindo os do bloco ainda em escrita: a posição vem do
+// contador do canal que o escreve. Se a interrupção avançar head no meio da
+// leitura, o contador pode ser já o do bloco seguinte, e a leitura se repete.
+// Retorna o número de quadros aceitos
+uint32_t ingest_poll(void) {
+  uint32_t h, t_us, left;
+  do {
+    h = head;
+    t_us = head_us;
+    __dmb();
+    left = dma_channel_hw_addr(dma_channels[(h / INGEST_BLOCK_BYTES) & 1])->transfer_count;
+    __dmb();
+  } while (h != head);
+  if (left < INGEST_BLOCK_BYTES)
+    t_us = time_us_32();
+  return ingest_parse(&parser, h + INGEST_BLOCK_BYTES - left, t_us);
+}
+
+bool ingest_latest(ingest_values_t *out) {
+  return ingest_read(&parser, out);
+}
+
+const ingest_stats_t *ingest_stats(void) {
+  return &parser.stats;
+}
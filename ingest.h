@@ -0,0 +1,86 @@
+#pragma once
+
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+
+// Dados do veículo recebidos pela UART. O controlador envia quadros
+//
+//   0xA5 0x5A len seq payload[len] crc_lo crc_hi
+//
+// com o CRC-16/CCITT (polinômio 0x1021, início 0xFFFF) de len, seq e payload.
+// seq conta os quadros enviados (módulo 256), para detectar perdas. O payload,
+// em little-endian, começa por
+//
+//   velocidade   uint16, 0,1 km/h
+//   combustível  uint16, 0,1 L
+//   flags        uint8, INGEST_FLAG_*
+//
+// e campos acrescentados depois dele são ignorados.
+//
+// O DMA recebe os bytes em blocos de INGEST_BLOCK_BYTES num anel, com dois
+// canais encadeados que se alternam; a interrupção de fim de bloco só rearma
+// o canal e avança head. ingest_poll(), fora dela, soma a head o que o canal
+// ativo já escreveu do bloco seguinte, analisa os quadros direto no anel, sem
+// cópia, e publica só os valores do mais recente.
+
+#define INGEST_SYNC0 0xA5
+#define INGEST_SYNC1 0x5A
+#define INGEST_HEADER_BYTES 4 // Sincronismo, len e seq
+#define INGEST_CRC_BYTES 2
+#define INGEST_PAYLOAD_MIN 5
+#define INGEST_PAYLOAD_MAX 32
+#define INGEST_FRAME_MAX (INGEST_HEADER_BYTES + INGEST_PAYLOAD_MAX + INGEST_CRC_BYTES)
+
+#define INGEST_RING_BITS 8    // Anel de 256 bytes
+#define INGEST_BLOCK_BYTES 16 // Bytes por transferência de DMA; divide o anel
+
+enum {
+  INGEST_FLAG_MM = 1u << 0, // Modo "MM On"
+};
+
+typedef struct {
+  uint32_t seq;         // Quadros aceitos até este (0 = nenhum ainda)
+  uint32_t t_us;        // ingest_poll() que viu o quadro completo (ou fim do bloco)
+  uint16_t speed;       // 0,1 km/h
+  uint16_t fuel;        // 0,1 L
+  uint8_t flags;
+  uint8_t frame_seq;    // seq do próprio quadro
+} ingest_values_t;
+
+typedef struct {
+  uint32_t frames;    // Quadros aceitos
+  uint32_t crc_errors;
+  uint32_t skipped;   // Bytes descartados procurando sincronismo
+  uint32_t lost;      // Quadros que faltaram na sequência de seq
+  uint32_t overruns;  // Vezes em que o DMA alcançou bytes ainda não analisados
+} ingest_stats_t;
+
+// Analisador sobre um anel de bytes qualquer (o do DMA, ou um buffer no bench)
+typedef struct {
+  const uint8_t *ring;
+  uint32_t mask;            // Tamanho do anel - 1 (potência de 2)
+  uint32_t window;          // Bytes antes de head que ainda não foram sobrescritos
+  uint32_t tail;            // Próximo byte a analisar, em bytes recebidos desde o início
+  uint8_t last_seq;         // seq do último quadro aceito
+  volatile uint32_t version; // Ímpar durante a publicação
+  ingest_values_t latest;
+  ingest_stats_t stats;
+} ingest_parser_t;
+
+typedef struct {
+  uart_inst_t *uart;
+  uint rx_pin;
+  uint baudrate;
+} ingest_config_t;
+
+void ingest_parser_init(ingest_parser_t *p, const uint8_t *ring, uint32_t size, uint32_t window);
+uint32_t ingest_parse(ingest_parser_t *p, uint32_t head, uint32_t t_us);
+bool ingest_read(const ingest_parser_t *p, ingest_values_t *out);
+
+uint16_t ingest_crc16(const uint8_t *data, uint len);
+uint ingest_encode(uint8_t *frame, uint8_t seq, uint16_t speed, uint16_t fuel, uint8_t flags);
+
+void ingest_init(const ingest_config_t *config);
+uint32_t ingest_poll(void);
+bool ingest_latest(ingest_values_t *out);
+const ingest_stats_t *ingest_stats(void);
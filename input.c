@@ -0,0 +1,157 @@
+#include <string.h>
+#include "input.h"
+#include "hardware/sync.h"
+#include "spsc_queue.h"
+#include "trace.h"
+
+typedef struct {
+  uint8_t pin;
+  volatile bool pressed;  // Estado já filtrado
+  bool settling;          // Alarme pendente é o fim da janela de debounce
+  volatile bool rearm;    // Borda aceita pela interrupção, alarme a armar em input_drain
+  uint32_t last_edge_us;  // Última borda aceita
+  alarm_id_t alarm;       // Fim do debounce ou aperto longo pendente (0 se nenhum)
+} input_button_t;
+
+static input_config_t config = {
+  .debounce_us = 50000,
+  .long_press_us = 800000,
+};
+
+static input_button_t buttons[INPUT_MAX_BUTTONS];
+static uint n_buttons;
+static int8_t button_of_pin[NUM_BANK0_GPIOS]; // Índice em buttons, -1 se o pino não é botão
+
+// A interrupção do GPIO e a do alarme têm a mesma prioridade e não se
+// interrompem, então o lado produtor da fila tem um só dono
+static input_event_t queue_storage[INPUT_QUEUE_SIZE];
+static spsc_queue_t queue;
+
+static void input_push(uint8_t pin, input_event_type_t type, uint32_t t_us) {
+  input_event_t ev = {.t_us = t_us, .pin = pin, .type = type};
+  spsc_queue_push(&queue, &ev);
+  if (config.notify)
+    config.notify(config.notify_arg);
+}
+
+static void input_accept(input_button_t *b, bool pressed, uint32_t now) {
+  b->last_edge_us = now;
+  b->pressed = pressed;
+  b->settling = true;
+  input_push(b->pin, pressed ? INPUT_PRESS : INPUT_RELEASE, now);
+}
+
+// Fim da janela de debounce: relê o pino para não perder uma borda ignorada
+// dentro dela (toque mais curto que a janela) e, com o botão ainda apertado,
+// passa a contar o aperto longo
+static int64_t input_alarm_cb(alarm_id_t id, void *user_data) {
+  (void)id;
+  input_button_t *b = user_data;
+  if (b->rearm) {
+    // Alarme de antes da última borda: input_drain arma o da janela nova
+    b->alarm = 0;
+    return 0;
+  }
+  if (!b->settling) {
+    b->alarm = 0;
+    if (b->pressed)
+      input_push(b->pin, INPUT_LONG_PRESS, time_us_32());
+    return 0;
+  }
+  bool pressed = !gpio_get(b->pin);
+  if (pressed != b->pressed) {
+    input_accept(b, pressed, time_us_32());
+    return config.debounce_us;
+  }
+  b->settling = false;
+  if (pressed && config.long_press_us > config.debounce_us)
+    return config.long_press_us - config.debounce_us;
+  b->alarm = 0;
+  return 0;
+}
+
+// Cada borda é comparada só com a última aceita do próprio pino: apertos em
+// botões diferentes nunca se anulam. Repiques saem nas primeiras comparações.
+// O nível vem do pino, não de events, que traz as duas bordas quando ambas
+// foram registradas antes do atendimento. A API de alarmes (trava e fila
+// ordenada do pool) fica fora daqui: a borda aceita só marca rearm
+static void input_gpio_irq(uint gpio, uint32_t events) {
+  (void)events;
+  int8_t i = gpio < NUM_BANK0_GPIOS ? button_of_pin[gpio] : -1;
+  if (i < 0)
+    return;
+  input_button_t *b = &buttons[i];
+  uint32_t now = time_us_32();
+  bool pressed = !gpio_get(gpio);
+  trace_gpio(now, gpio, !pressed);
+  if (now - b->last_edge_us < config.debounce_us || pressed == b->pressed)
+    return;
+  input_accept(b, pressed, now);
+  b->rearm = true;
+}
+
+// Arma o fim da janela de debounce das bordas aceitas pela interrupção, no
+// instante em que ela termina. Roda com as interrupções desligadas para que
+// a borda seguinte e o alarme não mexam no botão no meio da troca
+static void input_arm_alarms(void) {
+  for (uint i = 0; i < n_buttons; ++i) {
+    input_button_t *b = &buttons[i];
+    if (!b->rearm)
+      continue;
+    uint32_t save = save_and_disable_interrupts();
+    if (b->alarm)
+      cancel_alarm(b->alarm);
+    b->rearm = false;
+    uint32_t elapsed = time_us_32() - b->last_edge_us;
+    uint32_t left = elapsed < config.debounce_us ? config.debounce_us - elapsed : 0;
+    alarm_id_t id = add_alarm_in_us(left, input_alarm_cb, b, true);
+    b->alarm = id > 0 ? id : 0;
+    restore_interrupts(save);
+  }
+}
+
+void input_init(const input_config_t *cfg) {
+  if (cfg)
+    config = *cfg;
+  memset(button_of_pin, -1, sizeof(button_of_pin));
+  n_buttons = 0;
+  spsc_queue_init(&queue, queue_storage, sizeof(input_event_t), INPUT_QUEUE_SIZE);
+}
+
+// Configura o pino como entrada com pull-up e habilita as duas bordas
+bool input_add_button(uint pin) {
+  if (n_buttons == INPUT_MAX_BUTTONS || pin >= NUM_BANK0_GPIOS || button_of_pin[pin] >= 0)
+    return false;
+  input_button_t *b = &buttons[n_buttons];
+  memset(b, 0, sizeof(*b));
+  b->pin = pin;
+  // A primeira borda não pode cair na janela de debounce do instante zero
+  b->last_edge_us = time_us_32() - config.debounce_us;
+  button_of_pin[pin] = n_buttons++;
+
+  gpio_init(pin);
+  gpio_set_dir(pin, GPIO_IN);
+  gpio_pull_up(pin);
+  gpio_set_irq_enabled_with_callback(pin, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, input_gpio_irq);
+  return true;
+}
+
+// Copia até max eventos, do mais antigo ao mais novo; retorna quantos. Também
+// arma os alarmes de debounce pendentes, então deve ser chamada a cada notify
+uint input_drain(input_event_t *events, uint max) {
+  input_arm_alarms();
+  uint n = 0;
+  while (n < max && spsc_queue_pop(&queue, &events[n]))
+    ++n;
+  return n;
+}
+
+bool input_is_pressed(uint pin) {
+  int8_t i = pin < NUM_BANK0_GPIOS ? button_of_pin[pin] : -1;
+  return i >= 0 && buttons[i].pressed;
+}
+
+// Eventos perdidos por a fila estar cheia
+uint32_t input_dropped(void) {
+  return queue.dropped;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+#define INPUT_MAX_BUTTONS 4
+#define INPUT_QUEUE_SIZE 16 // Potência de 2
+
+typedef enum {
+  INPUT_PRESS,
+  INPUT_RELEASE,
+  INPUT_LONG_PRESS, // Botão ainda pressionado long_press_us após o aperto
+} input_event_type_t;
+
+typedef struct {
+  uint32_t t_us; // Instante da borda (ou do disparo do aperto longo)
+  uint8_t pin;
+  uint8_t type;  // input_event_type_t
+} input_event_t;
+
+// Chamada da interrupção depois de enfileirar eventos, para acordar o consumidor
+typedef void (*input_notify_fn_t)(void *arg);
+
+typedef struct {
+  uint32_t debounce_us;   // Bordas do mesmo pino dentro desse intervalo são repique
+  uint32_t long_press_us; // 0 desliga o evento de aperto longo
+  input_notify_fn_t notify;
+  void *notify_arg;
+} input_config_t;
+
+// Botões ativos em nível baixo com pull-up. Cada pino tem o próprio estado de
+// debounce; a interrupção só registra o evento com o instante da borda numa fila
+// sem trava, esvaziada em lotes fora dela por input_drain(), que também arma o
+// alarme do fim da janela de debounce (releitura do pino e aperto longo)
+void input_init(const input_config_t *config);
+bool input_add_button(uint pin);
+uint input_drain(input_event_t *events, uint max);
+bool input_is_pressed(uint pin);
+uint32_t input_dropped(void);
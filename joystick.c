@@ -0,0 +1,151 @@
+#include <string.h>
+#include "joystick.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+// Amostragem contínua dos dois eixos: o ADC alterna ADC0/ADC1 em round robin,
+// a FIFO é esvaziada por dois canais de DMA encadeados em pingue-pongue sobre
+// as duas metades de um buffer circular, e a interrupção de fim de cada bloco
+// faz a média, o filtro IIR e publica o resultado numa única palavra de 32
+// bits, lida sem trava por joystick_read().
+
+#define JOYSTICK_IIR_FRAC 4 // Bits fracionários do estado do filtro
+#define ADC_CLOCK_HZ 48000000
+
+static const joystick_config_t joystick_defaults = {
+  .sample_rate_hz = 2000,
+  .oversample = 16,
+  .iir_shift = 1,
+};
+
+static joystick_config_t config;
+static uint16_t ring[2][2 * JOYSTICK_MAX_OVERSAMPLE]; // X e Y intercalados
+static int dma_channels[2];
+static uint32_t iir_x, iir_y; // Estado do filtro com JOYSTICK_IIR_FRAC bits fracionários
+static volatile uint32_t latest; // Y filtrado << 16 | X filtrado, em contagens com fração
+static volatile uint32_t blocks;
+static volatile uint32_t latest_us; // Instante de latest; pode vir de um bloco à frente
+static struct {
+  uint16_t center_x, center_y;
+  uint16_t min_x, max_x, min_y, max_y;
+} cal = {2048, 2048, 0, 4095, 0, 4095};
+
+static void joystick_block(const uint16_t *samples) {
+  uint32_t sum_x = 0, sum_y = 0;
+  for (uint i = 0; i < config.oversample; ++i) {
+    sum_x += samples[2 * i];
+    sum_y += samples[2 * i + 1];
+  }
+  uint32_t x = (sum_x << JOYSTICK_IIR_FRAC) / config.oversample;
+  uint32_t y = (sum_y << JOYSTICK_IIR_FRAC) / config.oversample;
+  if (blocks == 0 || config.iir_shift == 0) {
+    iir_x = x;
+    iir_y = y;
+  } else {
+    iir_x += ((int32_t)(x - iir_x)) >> config.iir_shift;
+    iir_y += ((int32_t)(y - iir_y)) >> config.iir_shift;
+  }
+  latest = (iir_y << 16) | iir_x;
+  latest_us = time_us_32();
+  blocks = blocks + 1;
+}
+
+// Fim de um bloco: o outro canal já assumiu a FIFO pelo encadeamento; este
+// é rearmado para a mesma metade e processado enquanto a outra enche
+static void joystick_dma_irq_handler(void) {
+  for (uint half = 0; half < 2; ++half) {
+    int ch = dma_channels[half];
+    if (dma_channel_get_irq0_status(ch)) {
+      dma_channel_acknowledge_irq0(ch);
+      dma_channel_set_write_addr(ch, ring[half], false);
+      dma_channel_set_trans_count(ch, 2 * config.oversample, false);
+      joystick_block(ring[half]);
+    }
+  }
+}
+
+void joystick_init(const joystick_config_t *cfg) {
+  config = cfg ? *cfg : joystick_defaults;
+  if (config.oversample == 0)
+    config.oversample = 1;
+  if (config.oversample > JOYSTICK_MAX_OVERSAMPLE)
+    config.oversample = JOYSTICK_MAX_OVERSAMPLE;
+
+  adc_init();
+  adc_gpio_init(JOYSTICK_X_PIN);
+  adc_gpio_init(JOYSTICK_Y_PIN);
+  adc_select_input(0);
+  adc_set_round_robin(0x03);
+  adc_fifo_setup(true, true, 1, false, false);
+  // Conversões a cada (1 + div) ciclos de 48 MHz, para os dois eixos
+  adc_set_clkdiv((float)ADC_CLOCK_HZ / (2 * config.sample_rate_hz) - 1.0f);
+
+  dma_channels[0] = dma_claim_unused_channel(true);
+  dma_channels[1] = dma_claim_unused_channel(true);
+  for (uint half = 0; half < 2; ++half) {
+    int ch = dma_channels[half];
+    dma_channel_config c = dma_channel_get_default_config(ch);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, DREQ_ADC);
+    channel_config_set_chain_to(&c, dma_channels[half ^ 1]);
+    dma_channel_configure(ch, &c, ring[half], &adc_hw->fifo, 2 * config.oversample, false);
+    dma_channel_set_irq0_enabled(ch, true);
+  }
+  irq_add_shared_handler(DMA_IRQ_0, joystick_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_0, true);
+
+  dma_channel_start(dma_channels[0]);
+  adc_run(true);
+
+  // O primeiro bloco inicializa o filtro; até lá não há leitura válida
+  while (blocks == 0)
+    tight_loop_contents();
+}
+
+// Mapeia a contagem para -FULL_SCALE..+FULL_SCALE com centro e extremos calibrados
+static int16_t joystick_scale(uint16_t raw, uint16_t center, uint16_t min, uint16_t max) {
+  int32_t d = (int32_t)raw - center;
+  int32_t span = d < 0 ? center - min : max - center;
+  if (span <= 0)
+    return 0;
+  int32_t v = d * JOYSTICK_FULL_SCALE / span;
+  if (v > JOYSTICK_FULL_SCALE)
+    v = JOYSTICK_FULL_SCALE;
+  if (v < -JOYSTICK_FULL_SCALE)
+    v = -JOYSTICK_FULL_SCALE;
+  return v;
+}
+
+// Não bloqueia: uma leitura de 32 bits traz X e Y do mesmo bloco
+joystick_state_t joystick_read(void) {
+  uint32_t v = latest;
+  joystick_state_t s;
+  s.raw_x = (v & 0xFFFF) >> JOYSTICK_IIR_FRAC;
+  s.raw_y = (v >> 16) >> JOYSTICK_IIR_FRAC;
+  s.x = joystick_scale(s.raw_x, cal.center_x, cal.min_x, cal.max_x);
+  s.y = joystick_scale(s.raw_y, cal.center_y, cal.min_y, cal.max_y);
+  s.t_us = latest_us;
+  return s;
+}
+
+// Toma a posição atual (alavanca solta) como centro
+void joystick_calibrate_center(void) {
+  joystick_state_t s = joystick_read();
+  cal.center_x = s.raw_x;
+  cal.center_y = s.raw_y;
+}
+
+// Contagens nos fins de curso de cada eixo
+void joystick_set_extents(uint16_t min_x, uint16_t max_x, uint16_t min_y, uint16_t max_y) {
+  cal.min_x = min_x;
+  cal.max_x = max_x;
+  cal.min_y = min_y;
+  cal.max_y = max_y;
+}
+
+uint32_t joystick_blocks(void) {
+  return blocks;
+}
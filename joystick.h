@@ -0,0 +1,27 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+#define JOYSTICK_X_PIN 26 // ADC0
+#define JOYSTICK_Y_PIN 27 // ADC1
+#define JOYSTICK_MAX_OVERSAMPLE 64
+#define JOYSTICK_FULL_SCALE 1000 // Valor calibrado no fim de curso
+
+typedef struct {
+  uint32_t sample_rate_hz; // Amostras por segundo de cada eixo
+  uint8_t oversample;      // Amostras por eixo em cada bloco, média simples (boxcar) e decimação
+  uint8_t iir_shift;       // Passa-baixas y += (x - y) >> iir_shift sobre os blocos; 0 desliga
+} joystick_config_t;
+
+// Leitura filtrada mais recente
+typedef struct {
+  uint16_t raw_x, raw_y; // Contagens do ADC (0-4095)
+  int16_t x, y;          // Calibrado: -JOYSTICK_FULL_SCALE a +JOYSTICK_FULL_SCALE, 0 no centro
+  uint32_t t_us;         // time_us_32() no fim do bloco que produziu a leitura
+} joystick_state_t;
+
+void joystick_init(const joystick_config_t *config);
+joystick_state_t joystick_read(void);
+void joystick_calibrate_center(void);
+void joystick_set_extents(uint16_t min_x, uint16_t max_x, uint16_t min_y, uint16_t max_y);
+uint32_t joystick_blocks(void);
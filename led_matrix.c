@@ -0,0 +1,162 @@
+#include <string.h>
+#include "led_matrix.h"
+#include "ws2818b.pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+// Correção de gama 2.2: intensidade percebida (0-255) para o ciclo de trabalho
+// do WS2812. Gerada com round(255 * (i / 255) ^ 2.2)
+static const uint8_t matrix_gamma[256] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+    1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+    3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+    6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+   12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+   20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+   30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+   42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+   56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+   73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+   91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+  113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+  137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+  163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+  192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+  223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+// Instâncias atendidas pelo tratador compartilhado de DMA_IRQ_0
+static led_matrix_t *dma_matrices[LED_MATRIX_MAX];
+
+// Fim do intervalo de reset: a fita travou o quadro e aceita o próximo
+static int64_t matrix_latch_alarm(alarm_id_t id, void *user_data) {
+  (void)id;
+  led_matrix_t *m = user_data;
+  m->latch_alarm = 0;
+  m->busy = false;
+  if (m->latch_cb)
+    m->latch_cb(m, m->latch_cb_arg);
+  return 0;
+}
+
+// O DMA termina quando a última palavra entra na FIFO; ainda faltam as que
+// estão nela e a do OSR antes que a linha fique em repouso
+static void matrix_dma_irq_handler(void) {
+  for (uint i = 0; i < LED_MATRIX_MAX; ++i) {
+    led_matrix_t *m = dma_matrices[i];
+    if (m && dma_channel_get_irq0_status(m->dma_channel)) {
+      dma_channel_acknowledge_irq0(m->dma_channel);
+      uint pending = pio_sm_get_tx_fifo_level(m->pio, m->sm) + 1;
+      m->latch_alarm = add_alarm_in_us(pending * LED_MATRIX_LED_US + LED_MATRIX_RESET_US, matrix_latch_alarm, m, true);
+    }
+  }
+}
+
+// Reserva um canal de DMA que alimenta a TX FIFO com uma palavra de 32 bits por LED
+static void matrix_dma_init(led_matrix_t *m) {
+  static bool irq_installed = false;
+  m->dma_channel = dma_claim_unused_channel(true);
+  dma_channel_config c = dma_channel_get_default_config(m->dma_channel);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_dreq(&c, pio_get_dreq(m->pio, m->sm, true));
+  dma_channel_configure(m->dma_channel, &c, &m->pio->txf[m->sm], m->tx, LED_MATRIX_NUM_LEDS, false);
+
+  for (uint i = 0; i < LED_MATRIX_MAX; ++i) {
+    if (!dma_matrices[i]) {
+      dma_matrices[i] = m;
+      break;
+    }
+  }
+  dma_channel_set_irq0_enabled(m->dma_channel, true);
+  if (!irq_installed) {
+    irq_add_shared_handler(DMA_IRQ_0, matrix_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+    irq_installed = true;
+  }
+}
+
+void matrix_init(led_matrix_t *m, PIO pio, uint pin) {
+  memset(m, 0, sizeof(*m));
+  m->pio = pio;
+  m->brightness = 255;
+  uint offset = pio_add_program(pio, &ws2818b_program);
+  m->sm = pio_claim_unused_sm(pio, true);
+  ws2818b_program_init(pio, m->sm, offset, pin, LED_MATRIX_FREQ);
+  matrix_dma_init(m);
+}
+
+void matrix_set_pixel(led_matrix_t *m, uint index, uint8_t red, uint8_t green, uint8_t blue) {
+  if (index < LED_MATRIX_NUM_LEDS)
+    m->pixels[index] = matrix_pack_grb(red, green, blue);
+}
+
+void matrix_clear(led_matrix_t *m) {
+  memset(m->pixels, 0, sizeof(m->pixels));
+}
+
+// Aplica o brilho e a gama a um quadro: a escala é feita sobre a intensidade
+// percebida, então metade do brilho parece metade da luz
+static void matrix_encode(const led_matrix_t *m, uint32_t *dst, const uint32_t *src) {
+  uint32_t scale = m->brightness + 1u;
+  for (uint i = 0; i < LED_MATRIX_NUM_LEDS; ++i) {
+    uint32_t grb = src[i];
+    if (grb == 0) {
+      dst[i] = 0;
+      continue;
+    }
+    uint32_t g = matrix_gamma[((grb >> 24) * scale) >> 8];
+    uint32_t r = matrix_gamma[(((grb >> 16) & 0xFF) * scale) >> 8];
+    uint32_t b = matrix_gamma[(((grb >> 8) & 0xFF) * scale) >> 8];
+    dst[i] = (g << 24) | (r << 16) | (b << 8);
+  }
+}
+
+// Inicia a transmissão do quadro em edição sem esperar por ela. Retorna falso,
+// sem enviar nada, se o quadro anterior ainda não travou; pixels pode ser
+// alterado assim que a função retorna
+bool matrix_show(led_matrix_t *m) {
+  if (m->busy)
+    return false;
+  matrix_encode(m, m->tx, m->pixels);
+  m->busy = true;
+  m->shown_frame = NULL;
+  dma_channel_transfer_from_buffer_now(m->dma_channel, m->tx, LED_MATRIX_NUM_LEDS);
+  return true;
+}
+
+// Envia um quadro pronto de LED_MATRIX_NUM_LEDS palavras (por exemplo, uma
+// tabela const em flash) com o brilho atual. Nada é transmitido se quadro e
+// brilho são os do último envio. Retorna falso se o quadro anterior ainda não
+// travou; nesse caso a troca fica para a próxima chamada
+bool matrix_show_frame(led_matrix_t *m, const uint32_t *frame) {
+  if (frame == m->shown_frame && m->brightness == m->shown_brightness)
+    return true;
+  if (m->busy)
+    return false;
+  matrix_encode(m, m->tx, frame);
+  m->busy = true;
+  m->shown_frame = frame;
+  m->shown_brightness = m->brightness;
+  dma_channel_transfer_from_buffer_now(m->dma_channel, m->tx, LED_MATRIX_NUM_LEDS);
+  return true;
+}
+
+void matrix_set_brightness(led_matrix_t *m, uint8_t brightness) {
+  m->brightness = brightness;
+}
+
+void matrix_set_latch_callback(led_matrix_t *m, matrix_latch_cb_t cb, void *arg) {
+  m->latch_cb = cb;
+  m->latch_cb_arg = arg;
+}
+
+bool matrix_busy(const led_matrix_t *m) {
+  return m->busy;
+}
+
+void matrix_wait(const led_matrix_t *m) {
+  while (m->busy)
+    tight_loop_contents();
+}
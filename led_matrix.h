@@ -0,0 +1,57 @@
+#pragma once
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+#define LED_MATRIX_NUM_LEDS 25 // Matriz 5x5
+#define LED_MATRIX_MAX 2 // Instâncias atendidas pelo tratador de DMA
+#define LED_MATRIX_FREQ 800000.f // Bits por segundo na linha de dados
+#define LED_MATRIX_LED_US 30 // 24 bits a 800 kHz
+#define LED_MATRIX_RESET_US 300 // Linha em nível baixo para travar o quadro (WS2812B recentes pedem 280 us)
+
+// LED empacotado como a máquina de estados consome: G nos bits 31..24,
+// R em 23..16 e B em 15..8, enviados do mais significativo para o menos.
+// Nos quadros os canais são intensidades percebidas; o brilho global e a
+// correção de gama são aplicados no envio. Expressão constante, para tabelas
+// de quadros em flash
+#define MATRIX_GRB(red, green, blue) \
+  (((uint32_t)(green) << 24) | ((uint32_t)(red) << 16) | ((uint32_t)(blue) << 8))
+
+// Índice na fita do LED na linha/coluna da matriz (linha 0 em cima, coluna 0 à
+// esquerda): a fita serpenteia e começa no canto inferior direito
+#define LED_MATRIX_INDEX(row, col) (24 - ((row) * 5 + (((row) % 2 == 0) ? (col) : 4 - (col))))
+#define LED_MATRIX_SIZE 5 // Linhas e colunas
+
+static inline uint32_t matrix_pack_grb(uint8_t red, uint8_t green, uint8_t blue) {
+  return MATRIX_GRB(red, green, blue);
+}
+
+typedef struct led_matrix led_matrix_t;
+
+// Chamada da interrupção do alarme quando a fita trava o quadro enviado
+typedef void (*matrix_latch_cb_t)(led_matrix_t *m, void *arg);
+
+struct led_matrix {
+  PIO pio;
+  uint sm;
+  uint32_t pixels[LED_MATRIX_NUM_LEDS]; // Quadro em edição
+  uint32_t tx[LED_MATRIX_NUM_LEDS];     // Quadro sendo transmitido pelo DMA
+  int dma_channel;
+  alarm_id_t latch_alarm;
+  volatile bool busy; // Transmissão ou intervalo de reset em andamento
+  uint8_t brightness; // Escala global aplicada no envio (255 = sem atenuação)
+  const uint32_t *shown_frame; // Último quadro pronto enviado (NULL após matrix_show)
+  uint8_t shown_brightness;
+  matrix_latch_cb_t latch_cb;
+  void *latch_cb_arg;
+};
+
+void matrix_init(led_matrix_t *m, PIO pio, uint pin);
+void matrix_set_pixel(led_matrix_t *m, uint index, uint8_t red, uint8_t green, uint8_t blue);
+void matrix_clear(led_matrix_t *m);
+bool matrix_show(led_matrix_t *m);
+bool matrix_show_frame(led_matrix_t *m, const uint32_t *frame);
+void matrix_set_brightness(led_matrix_t *m, uint8_t brightness);
+bool matrix_busy(const led_matrix_t *m);
+void matrix_set_latch_callback(led_matrix_t *m, matrix_latch_cb_t cb, void *arg);
+void matrix_wait(const led_matrix_t *m);
@@ -0,0 +1,113 @@
+#include <string.h>
+#include "matrix_anim.h"
+
+void matrix_anim_init(matrix_anim_t *a, led_matrix_t *m, uint32_t duration_us, uint32_t refresh_hz) {
+  memset(a, 0, sizeof(*a));
+  a->m = m;
+  a->pos = MATRIX_ANIM_ONE;
+  uint64_t step = duration_us ? (uint64_t)MATRIX_ANIM_ONE * 1000000u / ((uint64_t)refresh_hz * duration_us) : MATRIX_ANIM_ONE;
+  a->step = step == 0 ? 1 : step > MATRIX_ANIM_ONE ? MATRIX_ANIM_ONE : step;
+}
+
+// Parte do que está na matriz: o quadro final da transição anterior, ou o
+// último quadro intermediário enviado se ela foi interrompida
+void matrix_anim_start(matrix_anim_t *a, const uint32_t *to, matrix_anim_mode_t mode, int dx, int dy) {
+  if (matrix_anim_active(a)) {
+    memcpy(a->from_buf, a->m->pixels, sizeof(a->from_buf));
+    a->from = a->from_buf;
+  } else {
+    a->from = a->to;
+  }
+  a->to = to;
+  a->mode = a->from ? mode : MATRIX_ANIM_CUT;
+  a->dx = dx > 0 ? 1 : dx < 0 ? -1 : 0;
+  a->dy = a->dx ? 0 : dy > 0 ? 1 : dy < 0 ? -1 : 0;
+  if (a->mode == MATRIX_ANIM_SLIDE && !a->dx && !a->dy)
+    a->mode = MATRIX_ANIM_FADE;
+  a->pos = a->mode == MATRIX_ANIM_CUT ? MATRIX_ANIM_ONE : 0;
+
+  if (a->mode == MATRIX_ANIM_FADE) {
+    for (uint i = 0; i < LED_MATRIX_NUM_LEDS; ++i) {
+      for (uint ch = 0; ch < 3; ++ch) {
+        uint shift = 24 - 8 * ch;
+        int32_t f = (a->from[i] >> shift) & 0xFF, t = (to[i] >> shift) & 0xFF;
+        a->acc[3 * i + ch] = f << 16;
+        a->delta[3 * i + ch] = (t - f) * (int32_t)a->step;
+      }
+    }
+  }
+}
+
+bool matrix_anim_active(const matrix_anim_t *a) {
+  return a->pos < MATRIX_ANIM_ONE;
+}
+
+// Interpolação de um LED empacotado, f em Q8
+static uint32_t anim_blend(uint32_t a, uint32_t b, int32_t f) {
+  uint32_t out = 0;
+  for (uint shift = 8; shift <= 24; shift += 8) {
+    int32_t ca = (a >> shift) & 0xFF, cb = (b >> shift) & 0xFF;
+    out |= (uint32_t)(ca + (((cb - ca) * f) >> 8)) << shift;
+  }
+  return out;
+}
+
+// Posição k de uma faixa de dez LEDs ao longo do movimento: o quadro antigo
+// seguido do novo, contados a partir da borda para onde o conteúdo anda
+static uint32_t anim_strip(const matrix_anim_t *a, uint k, uint across) {
+  const uint32_t *frame = k < LED_MATRIX_SIZE ? a->from : a->to;
+  uint along = k % LED_MATRIX_SIZE;
+  if ((a->dx ? a->dx : a->dy) > 0)
+    along = LED_MATRIX_SIZE - 1 - along;
+  return a->dx ? frame[LED_MATRIX_INDEX(across, along)] : frame[LED_MATRIX_INDEX(along, across)];
+}
+
+// Deslocamento de pos * LED_MATRIX_SIZE LEDs, com frações em Q8 interpoladas
+static void anim_slide(matrix_anim_t *a, uint32_t pos) {
+  uint32_t offset = (pos * LED_MATRIX_SIZE) >> 8;
+  for (uint row = 0; row < LED_MATRIX_SIZE; ++row) {
+    for (uint col = 0; col < LED_MATRIX_SIZE; ++col) {
+      uint along = a->dx ? col : row, across = a->dx ? row : col;
+      if ((a->dx ? a->dx : a->dy) > 0)
+        along = LED_MATRIX_SIZE - 1 - along;
+      uint32_t p = (along << 8) + offset;
+      uint k = p >> 8;
+      a->m->pixels[LED_MATRIX_INDEX(row, col)] = anim_blend(anim_strip(a, k, across), anim_strip(a, k + 1, across), p & 0xFF);
+    }
+  }
+}
+
+// Transição cruzada incremental: cada canal anda delta por quadro
+static void anim_fade(matrix_anim_t *a) {
+  for (uint i = 0; i < LED_MATRIX_NUM_LEDS; ++i) {
+    uint32_t grb = 0;
+    for (uint ch = 0; ch < 3; ++ch) {
+      int32_t v = (a->acc[3 * i + ch] += a->delta[3 * i + ch]) >> 16;
+      grb |= (uint32_t)(v < 0 ? 0 : v > 255 ? 255 : v) << (24 - 8 * ch);
+    }
+    a->m->pixels[i] = grb;
+  }
+}
+
+// Avança um quadro e o envia. Parada, reenvia o quadro final só se o brilho
+// mudou. Retorna falso se a matriz ainda trava o quadro anterior; o mesmo
+// passo é tentado na próxima chamada
+bool matrix_anim_tick(matrix_anim_t *a) {
+  if (!a->to)
+    return false;
+  if (!matrix_anim_active(a))
+    return matrix_show_frame(a->m, a->to);
+  if (matrix_busy(a->m))
+    return false;
+  uint32_t pos = a->pos + a->step;
+  if (pos >= MATRIX_ANIM_ONE) {
+    a->pos = MATRIX_ANIM_ONE;
+    return matrix_show_frame(a->m, a->to);
+  }
+  if (a->mode == MATRIX_ANIM_FADE)
+    anim_fade(a);
+  else
+    anim_slide(a, pos);
+  a->pos = pos;
+  return matrix_show(a->m);
+}
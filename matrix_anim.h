@@ -0,0 +1,32 @@
+#pragma once
+
+#include "led_matrix.h"
+
+#define MATRIX_ANIM_ONE 65536u // Progresso completo, em Q16
+
+typedef enum {
+  MATRIX_ANIM_CUT,   // Troca direta
+  MATRIX_ANIM_FADE,  // Transição cruzada, canal a canal
+  MATRIX_ANIM_SLIDE, // O quadro novo entra empurrando o antigo no sentido (dx, dy)
+} matrix_anim_mode_t;
+
+// Transição entre quadros prontos (tabelas em flash, como setas[]) sobre o
+// quadro em edição da matriz. Tudo em ponto fixo: matrix_anim_tick calcula e
+// envia um quadro por chamada, que deve ser feita na frequência passada a
+// matrix_anim_init. Brilho e gama ficam por conta do envio (led_matrix)
+typedef struct {
+  led_matrix_t *m;
+  const uint32_t *from, *to;
+  matrix_anim_mode_t mode;
+  int8_t dx, dy;
+  uint32_t pos;  // Progresso em Q16
+  uint32_t step; // Incremento por quadro em Q16
+  uint32_t from_buf[LED_MATRIX_NUM_LEDS]; // Quadro de partida quando uma transição interrompe outra
+  int32_t acc[LED_MATRIX_NUM_LEDS * 3];   // Transição cruzada: canais em Q16
+  int32_t delta[LED_MATRIX_NUM_LEDS * 3]; // e o quanto andam por quadro
+} matrix_anim_t;
+
+void matrix_anim_init(matrix_anim_t *a, led_matrix_t *m, uint32_t duration_us, uint32_t refresh_hz);
+void matrix_anim_start(matrix_anim_t *a, const uint32_t *to, matrix_anim_mode_t mode, int dx, int dy);
+bool matrix_anim_tick(matrix_anim_t *a);
+bool matrix_anim_active(const matrix_anim_t *a);
@@ -3,18 +3,71 @@
 #include "hardware/i2c.h" 
 #include "pico/stdlib.h" 
 #include "ssd1306.h"       
+#include "painel.h"
 #include <stdlib.h>   
 #include <stdio.h> 
 #include <math.h> 
-#include "font.h" 
-#include "ws2818b.pio.h"
-#include "hardware/adc.h" 
+#include "led_matrix.h"
+#include "matrix_anim.h"
+#include "setas.h"
+#include "joystick.h"
+#include "direction.h"
+#include "scheduler.h"
+#include "input.h"
+#include "widgets.h"
+#include "fonts.h"
+#include "spsc_queue.h"
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "ingest.h"
 
 // Definindo pinos para comunicação I2C
 #define I2C_PORT i2c1   
 #define I2C_SDA_PIN 14     
 #define I2C_SCL_PIN 15   
+#define I2C_FAST_HZ 1000000  // Fast-mode Plus, usado se o painel responder
 #define DISPLAY_ADDRESS 0x3C // Endereço I2C do display SSD1306
+#define I2C_AUX_PORT i2c0    // Segundo controlador, para displays auxiliares
+#define I2C_AUX_SDA_PIN 20   // 0 e 1 ficam com a UART0 da saída padrão
+#define I2C_AUX_SCL_PIN 21
+
+// Buffers dos displays em memória estática, sem heap
+SSD1306_STORAGE(buffers_principal, WIDTH, HEIGHT);
+
+// Displays auxiliares opcionais, usados se responderem na inicialização:
+// mostram velocidade e combustível, na geometria de cada um. Sem
+// PAINEL_OLED_AUX, ou com a geometria fixa de outro tamanho, os buffers
+// deles nem são reservados
+#if PAINEL_OLED_AUX && (!defined(SSD1306_FIXED_HEIGHT) || SSD1306_FIXED_HEIGHT == 32)
+#define AUX_128X32 1
+SSD1306_STORAGE(buffers_aux_32, 128, 32);
+#else
+#define AUX_128X32 0
+#endif
+#if PAINEL_OLED_AUX && (!defined(SSD1306_FIXED_HEIGHT) || SSD1306_FIXED_HEIGHT == 64)
+#define AUX_128X64 1
+SSD1306_STORAGE(buffers_aux_64, 128, 64);
+#else
+#define AUX_128X64 0
+#endif
+#define MAX_AUXILIARES (AUX_128X32 + AUX_128X64)
+
+#if MAX_AUXILIARES
+static const struct {
+    i2c_inst_t *i2c;
+    uint8_t address;
+    const ssd1306_storage_t *buffers;
+} config_auxiliares[MAX_AUXILIARES] = {
+#if AUX_128X32
+    {I2C_AUX_PORT, 0x3C, &buffers_aux_32}, // 128x32 no I2C0, pinos 20 e 21
+#endif
+#if AUX_128X64
+    {I2C_PORT, 0x3D, &buffers_aux_64},     // Segundo 128x64 no barramento do principal
+#endif
+};
+#endif
 
 // Definindo os pinos dos LEDs e botões
 #define LED_VERDE 11
@@ -26,12 +79,18 @@
 #define MATRIX_PIN 7 // Pino de controle da matriz de LEDs
 #define NUM_LEDS 25  // Número total de LEDs na matriz
 
-#define JOYSTICK_X 26  // Pino do eixo X
-#define JOYSTICK_Y 27  // Pino do eixo Y
 #define JOYSTICK_BUTTON 22 // Botão do Joystick
 
-static uint32_t last_time = 0; // Declaração correta da variável
-uint16_t estado_led = 0, eixo_x, eixo_y;
+// Dados do veículo (velocidade, combustível e modo) recebidos do controlador
+#define VEICULO_UART uart1
+#define VEICULO_RX_PIN 9
+#define VEICULO_BAUD 115200
+
+#define DEBOUNCE_US 50000     // Janela de repique, por botão
+#define APERTO_LONGO_US 800000
+static const uint8_t niveis_brilho[] = {255, 96, 24}; // Brilho da matriz, trocado com um clique no joystick
+uint16_t estado_led = 0;
+int16_t eixo_x, eixo_y; // Calibrados, -JOYSTICK_FULL_SCALE a +JOYSTICK_FULL_SCALE
 bool color = true;
 
 void init_leds() {
@@ -45,20 +104,60 @@ void init_leds() {
 }
 
 ssd1306_t display;
+
+typedef struct {
+    ssd1306_t ssd;
+    widget_t borda, velocidade, combustivel;
+    widget_number_t numero;
+    digits_cache_t digitos;
+} painel_auxiliar_t;
+
+static painel_auxiliar_t auxiliares[MAX_AUXILIARES ? MAX_AUXILIARES : 1]; // Os laços vão até n_auxiliares
+static uint n_auxiliares;
+ssd1306_group_t paineis; // Principal e auxiliares, enviados juntos
+static bool barramento_rapido[2] = {true, true}; // Todos os painéis do barramento aceitaram 1 MHz
+
+// Inicia os displays auxiliares que responderem. Cada barramento fica a 1 MHz
+// só se todos os painéis nele aceitarem. Com a geometria fixa na compilação,
+// os de outra geometria ficam de fora
+static void init_auxiliares() {
+#if AUX_128X32
+    i2c_bus_init(I2C_AUX_PORT, I2C_AUX_SDA_PIN, I2C_AUX_SCL_PIN, 400 * 1000); // Só o 128x32 fica no I2C0
+#endif
+#if MAX_AUXILIARES
+    for (uint i = 0; i < MAX_AUXILIARES; ++i) {
+      const ssd1306_storage_t *buffers = config_auxiliares[i].buffers;
+      if (!ssd1306_supports(buffers->width, buffers->height) ||
+          !ssd1306_present(config_auxiliares[i].i2c, config_auxiliares[i].address)) {
+        continue;
+      }
+      ssd1306_t *ssd = &auxiliares[n_auxiliares++].ssd;
+      ssd1306_init_static(ssd, buffers, false, config_auxiliares[i].address, config_auxiliares[i].i2c);
+      ssd1306_config(ssd);
+      uint barramento = i2c_hw_index(ssd->i2c_port);
+      if (barramento_rapido[barramento]) {
+        // Se este não aceitar, o barramento inteiro volta para 400 kHz
+        barramento_rapido[barramento] = ssd1306_probe_baudrate(ssd, I2C_FAST_HZ, 400 * 1000);
+      }
+      ssd1306_group_add(&paineis, ssd);
+    }
+#endif
+}
 // Inicialização e configurar do I2C e do display OLED SSD1306 
 void init_display() {
-    i2c_init(I2C_PORT, 400 * 1000); // Comunicação I2C com velocidade de 400 kHz
-    gpio_set_function(I2C_SDA_PIN, GPIO_FUNC_I2C);  // Configura o pino SDA para função I2C
-    gpio_set_function(I2C_SCL_PIN, GPIO_FUNC_I2C);  // Configura o pino SCL para função I2C
-    gpio_pull_up(I2C_SDA_PIN); 
-    gpio_pull_up(I2C_SCL_PIN); 
+    i2c_bus_init(I2C_PORT, I2C_SDA_PIN, I2C_SCL_PIN, 400 * 1000); // I2C a 400 kHz, com prazo e recuperação do barramento (i2c_bus.h)
 
-    ssd1306_init(&display, WIDTH, HEIGHT, false, DISPLAY_ADDRESS, I2C_PORT); // Inicializa o display SSD1306 com dimensões e endereço I2C
+    ssd1306_init_static(&display, &buffers_principal, false, DISPLAY_ADDRESS, I2C_PORT); // Inicializa o display SSD1306 nos buffers estáticos, com o endereço I2C
     ssd1306_config(&display);     // Configura o display com parâmetros adicionais
+    barramento_rapido[i2c_hw_index(I2C_PORT)] = ssd1306_probe_baudrate(&display, I2C_FAST_HZ, 400 * 1000); // Quadros mais curtos se o painel aceitar 1 MHz
     ssd1306_send_data(&display);  // Envia dados iniciais ao display
 
     ssd1306_fill(&display, false); // Limpa o display com pixels apagados
     ssd1306_send_data(&display);   // Atualiza o display para refletir a limpeza
+
+    ssd1306_group_init(&paineis);
+    ssd1306_group_add(&paineis, &display);
+    init_auxiliares(); // Displays extras, se presentes
 }
 
 void alternar_leds(uint16_t *estado_led) { 
@@ -80,36 +179,43 @@ void alternar_leds(uint16_t *estado_led) {
        *estado_led = (*estado_led + 1) % 3; // Alterna entre 0, 1 e 2
 }
 
-// Callback chamado quando ocorre interrupção em algum botão
-void botao_callback(uint gpio, uint32_t eventos) {
-    // Obtém o tempo atual em us
-    uint32_t current_time = to_us_since_boot(get_absolute_time());
-    // Verifica se passou tempo suficiente desde o último evento
-    if (current_time - last_time > 200000) { // 200 ms
-        //printf("led verde = %d\n", led_green);
-        last_time = current_time; // Atualiza o tempo do último evento
-        if (gpio == BOTAO_VERDE) { //  Botão A foi pressionado
-          gpio_put(LED_VERDE, !gpio_get(LED_VERDE)); // Alterna o LED Verde 
-        } else if (gpio == BOTAO_ALTERNAR) { //  Botão B foi pressionado
-          alternar_leds(&estado_led);
-        }
+// Ação de cada evento dos botões, fora da interrupção
+void tratar_entrada(const input_event_t *evento) {
+    if (evento->type == INPUT_PRESS) {
+      if (evento->pin == BOTAO_VERDE) { //  Botão A foi pressionado
+        gpio_put(LED_VERDE, !gpio_get(LED_VERDE)); // Alterna o LED Verde 
+      } else if (evento->pin == BOTAO_ALTERNAR) { //  Botão B foi pressionado
+        alternar_leds(&estado_led);
+      }
+    }
+    if (evento->pin == JOYSTICK_BUTTON) {
+      static bool aperto_longo = false;
+      static uint nivel_brilho = 0;
+      if (evento->type == INPUT_PRESS) {
+        aperto_longo = false;
+      } else if (evento->type == INPUT_LONG_PRESS) {
+        aperto_longo = true;
+        joystick_calibrate_center(); // Aperto longo no joystick solto: a posição atual vira o centro
+      } else if (!aperto_longo) {
+        // Clique: próximo nível de brilho; a matriz reenvia a seta no próximo quadro
+        nivel_brilho = (nivel_brilho + 1) % count_of(niveis_brilho);
+        matrix_set_brightness(&matriz, niveis_brilho[nivel_brilho]);
+      }
     }
 }
 
-void init_buttons() {
-    // Configura os pinos dos botões como entrada com pull-up
-    gpio_init(BOTAO_VERDE);
-    gpio_init(BOTAO_ALTERNAR);
-    gpio_set_dir(BOTAO_VERDE, GPIO_IN);
-    gpio_set_dir(BOTAO_ALTERNAR, GPIO_IN);
-    gpio_pull_up(BOTAO_VERDE); // Habilita pull-up no pino 5
-    gpio_pull_up(BOTAO_ALTERNAR); // Habilita pull-up no pino 6
-    gpio_set_irq_enabled_with_callback(BOTAO_VERDE, GPIO_IRQ_EDGE_FALL, true, botao_callback);
-    gpio_set_irq_enabled_with_callback(BOTAO_ALTERNAR, GPIO_IRQ_EDGE_FALL, true, botao_callback);
-    
-    adc_init();
-    adc_gpio_init(JOYSTICK_X);
-    adc_gpio_init(JOYSTICK_Y); 
+// Botões A, B e do joystick, com pull-up; notify é chamada da interrupção a cada evento
+void init_buttons(input_notify_fn_t notify, void *arg) {
+    input_config_t config = {
+      .debounce_us = DEBOUNCE_US,
+      .long_press_us = APERTO_LONGO_US,
+      .notify = notify,
+      .notify_arg = arg,
+    };
+    input_init(&config);
+    input_add_button(BOTAO_VERDE);
+    input_add_button(BOTAO_ALTERNAR);
+    input_add_button(JOYSTICK_BUTTON);
 }
 
 // Função para converter as posições (x, y) da matriz para um índice do vetor de LEDs
@@ -120,258 +226,559 @@ int get_led_index(int x, int y) {
         return 24 - (x * 5 + (4 - y)); // Calcula o índice invertendo a posição dos LEDs
 }}
 
-// Definição da estrutura de cor para cada LED
-struct pixel_t {
-    uint8_t red, green, blue; // Componentes de cor: vermelho, verde e azul
-};
-typedef struct pixel_t led_t; // Cria um tipo led_t baseado em pixel_t
-led_t leds[NUM_LEDS]; // Vetor que armazena as cores de todos os LEDs
+led_matrix_t matriz; // Quadro GRB empacotado, enviado por DMA ao PIO
 
-// PIO e state machine para controle dos LEDs
-PIO pio; // PIO utilizado para comunicação com os LEDs
-uint state_machine;   // State machine associada ao PIO
-
-// Função para atualizar os LEDs da matriz
+// Função para atualizar os LEDs da matriz
 void update_leds() {
-    for (uint i = 0; i < NUM_LEDS; ++i) { // Percorre todos os LEDs
-        pio_sm_put_blocking(pio, state_machine, leds[i].red); // Envia valor do componente vermelho
-        pio_sm_put_blocking(pio, state_machine, leds[i].green); // Envia valor do componente verde
-        pio_sm_put_blocking(pio, state_machine, leds[i].blue); // Envia valor do componente azul
-    }   
+    // Só espera se o quadro anterior ainda não travou; o envio segue por DMA
+    matrix_wait(&matriz);
+    matrix_show(&matriz);
 }
-// Função de controle inicial da matriz de LEDs
+// Função de controle inicial da matriz de LEDs
 void init_matrix(uint pin) {
-    uint offset = pio_add_program(pio0, &ws2818b_program); // Carrega programa para controlar LEDs no PIO
-    pio = pio0; // Seleciona o PIO 0
-    state_machine = pio_claim_unused_sm(pio, true); // Reivindica uma state machine livre
-    ws2818b_program_init(pio, state_machine, offset, pin, 800000.f); // Inicializa o controle da matriz no pino especificado
-
-    for (uint i = 0; i < NUM_LEDS; ++i) { // Inicializa todos os LEDs com a cor preta (desligados)
-        leds[i].red = leds[i].green = leds[i].blue = 0;
-    }
-    update_leds(); // Atualiza o estado dos LEDs
+    matrix_init(&matriz, pio0, pin); // Carrega o programa no PIO 0 e reserva state machine e canal de DMA
+    update_leds(); // Atualiza o estado dos LEDs (todos apagados)
 }
-// Função para configurar a cor de um LED específico
+// Função para configurar a cor de um LED específico
 void set_led_color(const uint index, const uint8_t red, const uint8_t green, const uint8_t blue) {
-    leds[index].red = red; // Define o componente vermelho
-    leds[index].green = green; // Define o componente verde
-    leds[index].blue = blue; // Define o componente azul
+    matrix_set_pixel(&matriz, index, red, green, blue);
 }
-// Função para desligar todos os LEDs
+// Função para desligar todos os LEDs
 void turn_off_leds() {
-    for (uint i = 0; i < NUM_LEDS; ++i) { // Percorre todos os LEDs
-        set_led_color(i, 0, 0, 0); // Define a cor preta (desligado) para cada LED
-    }
+    matrix_clear(&matriz);
     update_leds();
 }
 
-// Desenhar as direções na matriz de LEDs
-void seta1() {  // Função para desenhar uma das direções na matriz de LEDs
-    int matrix[5][5][3] = {  // Matriz tridimensional para representar a cor de cada LED (5x5)
-        // Cada elemento [linha][coluna][RGB] define a cor de um LED
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}},   
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 255},  {0, 0, 0}},   
-        {{0, 0, 255}, {0, 0, 255}, {0, 0, 255}, {0, 0, 255},  {0, 0, 255}},    
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 255},  {0, 0, 0}},    
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}}    
-    };
-    // Loop para percorrer cada linha da matriz
-    for (int row = 0; row < 5; row++) {
-        for (int col = 0; col < 5; col++) {  // Loop para percorrer cada coluna
-            int position = get_led_index(row, col);  // Converte a posição da matriz para índice do vetor de LEDs
-            // Define a cor do LED na posição correspondente
-            set_led_color(position, matrix[row][col][0], matrix[row][col][1], matrix[row][col][2]);
-        }}  update_leds();
-}
-void seta2() {
-    int matrix[5][5][3] = {
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 255}, {0, 0, 255}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 255}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 255}},
-        {{0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 255}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}}
-    };
-    for (int row = 0; row < 5; row++) {
-        for (int col = 0; col < 5; col++) {
-            int position = get_led_index(row, col);
-            set_led_color(position, matrix[row][col][0], matrix[row][col][1], matrix[row][col][2]);
-        }}  update_leds();
-}
-void seta3() {
-    int matrix[5][5][3] = {
-        {{0, 0, 255}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 255}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 255}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 255}, {0, 0, 255}}
-    };
-    for (int row = 0; row < 5; row++) {
-        for (int col = 0; col < 5; col++) {
-            int position = get_led_index(row, col);
-            set_led_color(position, matrix[row][col][0], matrix[row][col][1], matrix[row][col][2]);
-        }}  update_leds();
-}
-void seta4() {
-    int matrix[5][5][3] = {
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 255}, {0, 0, 255}, {0, 0, 255}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}}
-    };
-    for (int row = 0; row < 5; row++) {
-        for (int col = 0; col < 5; col++) {
-            int position = get_led_index(row, col);
-            set_led_color(position, matrix[row][col][0], matrix[row][col][1], matrix[row][col][2]);
-        }}  update_leds();
-}
-void seta5() {
-    int matrix[5][5][3] = {
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 255}, {0, 0, 255}, {0, 0, 255}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}}
-    };
-    for (int row = 0; row < 5; row++) {
-        for (int col = 0; col < 5; col++) {
-            int position = get_led_index(row, col);
-            set_led_color(position, matrix[row][col][0], matrix[row][col][1], matrix[row][col][2]);
-        }}  update_leds();
-}
-void seta6() {
-    int matrix[5][5][3] = {
-        {{0, 0, 255}, {0, 0, 255}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 255}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 255}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 255}}
-    };
-    for (int row = 0; row < 5; row++) {
-        for (int col = 0; col < 5; col++) {
-            int position = get_led_index(row, col);
-            set_led_color(position, matrix[row][col][0], matrix[row][col][1], matrix[row][col][2]);
-        }}  update_leds();
-}
-void seta7() {
-    int matrix[5][5][3] = {
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 255}, {0, 0, 255}, {0, 0, 255}, {0, 0, 255}, {0, 0, 255}},
-        {{0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}}
-    };
-    for (int row = 0; row < 5; row++) {
-        for (int col = 0; col < 5; col++) {
-            int position = get_led_index(row, col);
-            set_led_color(position, matrix[row][col][0], matrix[row][col][1], matrix[row][col][2]);
-        }}  update_leds();
-}
-void seta8() {
-    int matrix[5][5][3] = {
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 255}},
-        {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}},
-        {{0, 0, 255}, {0, 0, 0}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 255}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}},
-        {{0, 0, 255}, {0, 0, 255}, {0, 0, 255}, {0, 0, 0}, {0, 0, 0}}
+// Setores de 45 graus a partir da direita, no sentido anti-horário. O X do
+// joystick é montado invertido (valores baixos mostram a seta para a
+// direita), então o classificador recebe -x
+static const direcao_t setas_setor[8] = {
+    DIRECAO_DIREITA, DIRECAO_CIMA_DIREITA, DIRECAO_CIMA, DIRECAO_CIMA_ESQUERDA,
+    DIRECAO_ESQUERDA, DIRECAO_BAIXO_ESQUERDA, DIRECAO_BAIXO, DIRECAO_BAIXO_DIREITA,
+};
+static const direction_config_t config_direcao = {
+    .deadzone = 200,           // 20% do curso
+    .radial_hysteresis = 50,
+    .angular_hysteresis = 512, // ~2.8 graus além da fronteira
+    .sectors = count_of(setas_setor),
+};
+static direction_classifier_t classificador;
+
+// Direção do joystick a partir dos eixos calibrados
+direcao_t classificar_direcao(int16_t eixo_x, int16_t eixo_y) {
+    static bool iniciado = false;
+    if (!iniciado) {
+      direction_init(&classificador, &config_direcao);
+      iniciado = true;
+    }
+    direction_t d = direction_classify(&classificador, -eixo_x, eixo_y);
+    return d.sector == DIRECTION_CENTER ? DIRECAO_CENTRO : setas_setor[d.sector];
+}
+
+// Mostra a seta da direção atual; a matriz só é retransmitida quando a seta
+// (ou o brilho) muda. Se o quadro anterior ainda não travou, tenta de novo na
+// próxima leitura
+void atualizar_matriz(int16_t *eixo_x, int16_t *eixo_y) {
+    matrix_show_frame(&matriz, setas[classificar_direcao(*eixo_x, *eixo_y)]);
+}
+// Última leitura filtrada dos eixos; a amostragem corre por DMA, sem esperas aqui
+// Retorna o instante da amostra lida
+uint32_t ler_joystick(int16_t *eixo_x, int16_t *eixo_y) {
+    joystick_state_t joystick = joystick_read();
+    trace_adc(joystick.t_us, joystick.raw_x, joystick.raw_y);
+    *eixo_x = joystick.x;
+    *eixo_y = joystick.y;
+    return joystick.t_us;
+}
+
+// Lê os LEDs de estado; chamada no núcleo 0, dono dos botões e dos LEDs
+painel_estado_t capturar_estado(int contador) {
+    painel_estado_t estado = {
+      .contador = contador,
+      .mm_on = gpio_get(LED_VERDE),
+      .gas_5l = gpio_get(LED_AZUL),
+      .gas_2l = gpio_get(LED_VERMELHO),
     };
-    for (int row = 0; row < 5; row++) {
-        for (int col = 0; col < 5; col++) {
-            int position = get_led_index(row, col);
-            set_led_color(position, matrix[row][col][0], matrix[row][col][1], matrix[row][col][2]);
-        }}  update_leds();
-}
-
-// Atualização do display
-void atualizar_matriz(uint16_t *eixo_x, uint16_t *eixo_y) {
-
-    if (*eixo_x < 1900) {
-      if ((*eixo_y < 2400) && (*eixo_y > 1800)){
-        seta1();
-      } else if (*eixo_y > 2400){
-        seta2();
-      } else if (*eixo_y < 2400){
-        seta3();
+    return estado;
+}
+
+bool estado_igual(const painel_estado_t *a, const painel_estado_t *b) {
+    return a->contador == b->contador && a->mm_on == b->mm_on &&
+           a->gas_5l == b->gas_5l && a->gas_2l == b->gas_2l;
+}
+
+// Elementos do painel. Cada um redesenha só a própria caixa, e só quando o
+// valor muda; a moldura envolve os demais e é desenhada primeiro
+static widget_t widget_borda, widget_modo, widget_velocidade, widget_combustivel;
+static const char *const rotulos_combustivel[] = {NULL, "Gas 5L", "Gas 2L"};
+static widget_number_t numero_velocidade;
+static digits_cache_t digitos_velocidade;
+
+// Glifos dos dígitos prontos para cópia; os grandes são descompactados uma vez na RAM
+static digits_font_t digitos_8x8, digitos_grandes;
+static uint8_t colunas_digitos_grandes[DIGITS_STORAGE_BYTES(FONT_DIGITOS_CELL_BYTES)];
+
+static void iniciar_widgets(bool color) {
+    digits_font_init(&digitos_8x8, &font_8x8, NULL, 0);
+    digits_font_init(&digitos_grandes, &font_digitos, colunas_digitos_grandes, sizeof(colunas_digitos_grandes));
+
+    widget_init(&widget_borda, 3, 3, 122, 58, color, widget_draw_frame, NULL);
+    widget_init(&widget_modo, 10, 10, 5 * 8, 8, color, widget_draw_label, "MM On");
+    // Velocidade em três células alinhadas à direita: a unidade fica parada e
+    // a contagem só reescreve os dígitos que mudam
+    digits_cache_init(&digitos_velocidade, &digitos_8x8, 3);
+    numero_velocidade = (widget_number_t){&digitos_velocidade, &font_8x8, " km|h"};
+    widget_init_number(&widget_velocidade, 45, 25, color, &numero_velocidade);
+    widget_init(&widget_combustivel, 10, 50, 6 * 8, 8, color, widget_draw_labels, rotulos_combustivel);
+    // Auxiliares: moldura na borda do painel, velocidade e combustível pela altura
+    for (uint i = 0; i < n_auxiliares; ++i) {
+      painel_auxiliar_t *aux = &auxiliares[i];
+      uint8_t w = ssd1306_width(&aux->ssd), h = ssd1306_height(&aux->ssd);
+      widget_init(&aux->borda, 0, 0, w, h, color, widget_draw_frame, NULL);
+      if (h >= 64) {
+        // Painel alto: velocímetro com os dígitos grandes
+        digits_cache_init(&aux->digitos, &digitos_grandes, 3);
+        aux->numero = (widget_number_t){&aux->digitos, &font_8x8_prop, " km|h"};
+        widget_init_number(&aux->velocidade, 8, 12, color, &aux->numero);
+      } else {
+        digits_cache_init(&aux->digitos, &digitos_8x8, 3);
+        aux->numero = (widget_number_t){&aux->digitos, &font_8x8, " km|h"};
+        widget_init_number(&aux->velocidade, 8, h / 4, color, &aux->numero);
       }
-    } else if ((*eixo_x < 2400) && (*eixo_x > 1800)){
-      if (*eixo_y > 2400){
-        seta4();
-      } else if (*eixo_y < 1900){
-        seta5();
+      widget_init(&aux->combustivel, 8, h / 2 + h / 4 - 8, 6 * 8, 8, color, widget_draw_labels, rotulos_combustivel);
+    }
+}
+
+// Atualiza o quadro do painel no buffer do display, sem enviá-lo. Usa só o
+// retrato recebido, sem tocar nos pinos. Retorna os widgets redesenhados
+// (PAINEL_*); com o estado igual ao anterior não há desenho nem o que enviar
+uint8_t desenhar_painel(bool color, const painel_estado_t *estado) {
+    static bool iniciado = false, cor;
+    if (!iniciado || cor != color) {
+      iniciar_widgets(color);
+      iniciado = true;
+      cor = color;
+    }
+
+    uint8_t mudou = 0;
+    if (widget_update(&display, &widget_borda, 0)) {
+      mudou |= PAINEL_BORDA;
+      // A moldura limpou a área interna: todos os outros precisam ser redesenhados
+      widget_invalidate(&widget_modo);
+      widget_invalidate(&widget_velocidade);
+      widget_invalidate(&widget_combustivel);
+    }
+    if (widget_update(&display, &widget_modo, estado->mm_on)) {
+      mudou |= PAINEL_MODO;
+    }
+    // Com "MM On" a velocidade sai da tela
+    if (widget_update(&display, &widget_velocidade, estado->mm_on ? -1 : estado->contador)) {
+      mudou |= PAINEL_VELOCIDADE;
+    }
+    if (widget_update(&display, &widget_combustivel, estado->gas_5l ? 1 : estado->gas_2l ? 2 : 0)) {
+      mudou |= PAINEL_COMBUSTIVEL;
+    }
+    for (uint i = 0; i < n_auxiliares; ++i) {
+      painel_auxiliar_t *aux = &auxiliares[i];
+      bool moldura = widget_update(&aux->ssd, &aux->borda, 0);
+      if (moldura) {
+        widget_invalidate(&aux->velocidade);
+        widget_invalidate(&aux->combustivel);
       }
-    } else if (*eixo_x > 2400){
-      if (*eixo_y > 2400){
-        seta6();
-      } else if ((*eixo_y < 2400) && (*eixo_y > 1800)){
-        seta7();
-      } else if (*eixo_y < 2400){
-        seta8();
+      bool velocidade = widget_update(&aux->ssd, &aux->velocidade, estado->contador);
+      bool combustivel = widget_update(&aux->ssd, &aux->combustivel, estado->gas_5l ? 1 : estado->gas_2l ? 2 : 0);
+      if (moldura || velocidade || combustivel) {
+        mudou |= PAINEL_AUXILIARES;
       }
     }
+    return mudou;
 }
 
-// Leitura dos valores do joystick
-void ler_joystick(uint16_t *eixo_x, uint16_t *eixo_y) {
-    adc_select_input(0);
-    sleep_us(20);
-    *eixo_x = adc_read();
-    adc_select_input(1);
-    sleep_us(20);
-    *eixo_y = adc_read();
+// Envia o que desenhar_painel mudou. Só a velocidade, a mudança de todo meio
+// segundo, sai como região direto do buffer: poucas dezenas de bytes, sem
+// cópia para o fluxo do DMA. O resto vai pelo envio por DMA das regiões
+// alteradas, em todos os displays de uma vez: os dois barramentos transmitem
+// juntos. Retorna false se um envio anterior ainda estiver em andamento
+bool enviar_painel(uint8_t mudou) {
+    if (mudou == PAINEL_VELOCIDADE) {
+      if (ssd1306_group_busy(&paineis)) {
+        return false;
+      }
+      widget_flush(&display, &widget_velocidade);
+      return true;
+    }
+    return ssd1306_group_flush(&paineis);
 }
 
-int main() {
-    init_matrix(MATRIX_PIN); // Configura controle na matriz
-    stdio_init_all(); // Inicializa a biblioteca padrão da Pico
-    init_leds();
-    init_buttons();
-    init_display(); // Inicializa o display
-    bool color = true; // Declarado corretamente antes de seu uso
-    int contador = 0;
-    char texto[16];
+#ifndef PAINEL_NO_MAIN
+// Divisão entre os núcleos: o 0 cuida do ADC, dos botões, da matriz de LEDs e
+// do estado do painel; o 1 é dono do buffer do display e do envio por I2C. O
+// estado passa do 0 para o 1 como retratos imutáveis numa fila sem trava, e
+// nenhum dos dois espera pelo outro
 
-    // Exibição inicial no display OLED
-    ssd1306_fill(&display, !color); // Limpa o display preenchendo com a cor oposta ao valor atual de "color"
-    ssd1306_rect(&display, 3, 3, 122, 58, color, !color); // Desenha um retângulo com bordas dentro das coordenadas especificadas
-    ssd1306_send_data(&display); // Envia os dados para atualizar o display
+// Períodos das tarefas do núcleo 0
+#define PERIODO_JOYSTICK_US 5000     // 200 Hz
+#define PERIODO_MATRIZ_US 20000      // 50 Hz, quadros das transições entre setas
+#define PERIODO_ESTADO_US 33333      // 30 Hz, taxa máxima de quadros do display
+#define PERIODO_VELOCIDADE_US 500000 // Contador de velocidade
+#define PERIODO_ESTATISTICAS_US 10000000
+#define PERIODO_TELEMETRIA_US 250000 // Drena as filas de registros antes que encham
+#define PERIODO_GRAVACAO_US 100000   // Exporta as entradas gravadas (trace.h) antes que a fila encha
+#define PERIODO_VEICULO_US 10000     // Analisa os quadros da UART; o anel do DMA comporta ~20 ms a 115200
+#define VEICULO_VALIDADE_US 500000   // Sem quadros por mais tempo, a velocidade sai da tela
+#define TELEMETRIA_EXPORTAR 20       // Drenagens por exportação em CSV (5 s)
 
-    // Desliga todos os LEDs inicialmente
-    gpio_put(LED_VERDE, 0);
-    gpio_put(LED_AZUL, 0);
-    gpio_put(LED_VERMELHO, 0);
+#define FILA_ESTADOS_TAMANHO 4 // Potência de 2
+#define DURACAO_TRANSICAO_US 160000 // Troca de seta: 8 quadros
 
-    while (true) {
+static scheduler_task_t tarefa_entradas, tarefa_joystick, tarefa_matriz, tarefa_veiculo, tarefa_estado, tarefa_velocidade, tarefa_estatisticas;
+static direcao_t direcao_pedida = DIRECAO_INDEFINIDA, direcao_mostrada = DIRECAO_INDEFINIDA;
+static int contador = 0; // Velocidade de demonstração, até chegar o primeiro quadro do veículo
+static ingest_values_t veiculo; // Últimos dados do veículo (seq 0: nenhum ainda)
 
-      ler_joystick(&eixo_x, &eixo_y);
-      atualizar_matriz(&eixo_x, &eixo_y);
+static matrix_anim_t animacao;
+// Sentido da transição para cada seta: as dos eixos entram deslizando para
+// onde apontam, as diagonais e o centro cruzam com a anterior
+static const struct {
+    int8_t dx, dy;
+} sentido_setas[DIRECAO_COUNT] = {
+    [DIRECAO_DIREITA] = {1, 0},
+    [DIRECAO_ESQUERDA] = {-1, 0},
+    [DIRECAO_CIMA] = {0, -1},
+    [DIRECAO_BAIXO] = {0, 1},
+};
 
-      fflush(stdout); // Certifica-se de que o buffer de saída seja limpo antes de aguardar a entrada
-      ssd1306_fill(&display, !color); // Limpa o display preenchendo com a cor oposta ao valor atual de "color"
-      ssd1306_rect(&display, 3, 3, 122, 58, color, !color); 
+// Etapas e latências medidas pela telemetria (telemetry.h)
+enum {
+    ETAPA_JOYSTICK,   // Leitura e classificação da direção
+    ETAPA_MATRIZ,     // Troca do quadro da matriz
+    ETAPA_DESENHO,    // desenhar_painel, no núcleo 1
+    ETAPA_ENVIO,      // enviar_painel: montagem do envio por DMA ou região bloqueante
+    ETAPA_BARRAMENTO, // Do início do envio ao último byte entregue ao I2C
+    LATENCIA_MATRIZ,  // Amostra do joystick com a nova direção até a matriz travar o quadro
+    LATENCIA_OLED,    // Entrada ou contador que mudou o estado até o fim do envio ao display
+    ETAPA_COUNT
+};
+static const char *const nomes_etapas[ETAPA_COUNT] = {
+    "joystick", "matriz", "desenho", "envio", "barramento", "lat_matriz", "lat_oled",
+};
 
-      if (gpio_get(LED_VERDE)){
-        ssd1306_draw_string(&display, "MM On", 10, 10);
-      } else {
-        snprintf(texto, sizeof(texto), "%d km|h", contador);
-        ssd1306_draw_string(&display, texto, 45, 25);
+// Instantes usados pelas latências
+static uint32_t direcao_us;          // Amostra em que direcao_pedida mudou
+static volatile uint32_t quadro_us;  // direcao_us do primeiro quadro da transição
+static volatile bool quadro_medir = false; // Próximo travamento é o do primeiro quadro
+static uint32_t mudanca_us;          // Primeira causa de mudança ainda não publicada
+static bool mudanca_marcada = false;
+static uint32_t envio_inicio_us, envio_estado_us; // Núcleo 1: envio em andamento
+
+static painel_estado_t estados[FILA_ESTADOS_TAMANHO];
+static spsc_queue_t fila_estados; // Núcleo 0 produz, núcleo 1 consome
+
+// Chamada da interrupção dos botões: só libera a tarefa que esvazia a fila
+static void notificar_entradas(void *arg) {
+    scheduler_post(arg);
+}
+
+// Trata em lotes os eventos enfileirados pela interrupção
+static void marcar_mudanca(uint32_t t_us) {
+    if (!mudanca_marcada) {
+      mudanca_us = t_us;
+      mudanca_marcada = true;
+    }
+}
+
+static void executar_entradas(void *arg) {
+    (void)arg;
+    input_event_t eventos[8];
+    uint n;
+    while ((n = input_drain(eventos, count_of(eventos))) > 0) {
+      for (uint i = 0; i < n; ++i) {
+        marcar_mudanca(eventos[i].t_us);
+        tratar_entrada(&eventos[i]);
       }
+    }
+}
 
-      ssd1306_send_data(&display); // Atualiza o display
+// Lê os eixos e libera a tarefa da matriz só quando a direção muda
+static void executar_joystick(void *arg) {
+    (void)arg;
+    TELEMETRY_SCOPE(ETAPA_JOYSTICK) {
+      uint32_t amostra_us = ler_joystick(&eixo_x, &eixo_y);
+      direcao_t direcao = classificar_direcao(eixo_x, eixo_y);
+      if (direcao != direcao_pedida) {
+        direcao_pedida = direcao;
+        direcao_us = amostra_us;
+      }
+      // Já liberada pelo próprio timer, a transição começa nessa execução
+      if (direcao_pedida != direcao_mostrada && !tarefa_matriz.ready) {
+        scheduler_post(&tarefa_matriz);
+      }
+    }
+}
 
-      if (gpio_get(LED_AZUL)){
-        ssd1306_draw_string(&display, "Gas 5L", 10, 50);
-      } else if (gpio_get(LED_VERMELHO)){
-        ssd1306_draw_string(&display, "Gas 2L", 10, 50);
-      } else {
-        ssd1306_rect(&display, 3, 3, 122, 58, color, !color); 
+// Começa a transição quando a direção muda (liberada pela tarefa do joystick)
+// e avança a animação um quadro por período. Se a matriz ainda trava o quadro
+// anterior, o passo fica para o próximo período
+static void executar_matriz(void *arg) {
+    (void)arg;
+    static bool primeiro_quadro = false;
+    TELEMETRY_SCOPE(ETAPA_MATRIZ) {
+      if (direcao_pedida != direcao_mostrada) {
+        int dx = sentido_setas[direcao_pedida].dx, dy = sentido_setas[direcao_pedida].dy;
+        matrix_anim_start(&animacao, setas[direcao_pedida], dx || dy ? MATRIX_ANIM_SLIDE : MATRIX_ANIM_FADE, dx, dy);
+        direcao_mostrada = direcao_pedida;
+        primeiro_quadro = true;
       }
-   
-      ssd1306_send_data(&display); // Envia os dados para atualizar o display
-                      
-      contador++;
-      if (contador > 100) {  
-        contador = 0;                
+      if (matrix_anim_tick(&animacao) && primeiro_quadro) {
+        primeiro_quadro = false;
+        quadro_us = direcao_us;
+        quadro_medir = true;
       }
-          sleep_ms(500);
     }
 }
+
+// Analisa os quadros que chegaram pela UART e guarda os valores do mais
+// recente. Os LEDs passam a seguir os dados, como indicadores: verde com
+// "MM On", azul na reserva de 5 L e vermelho na de 2 L
+static void executar_veiculo(void *arg) {
+    (void)arg;
+    if (ingest_poll() == 0) {
+      return;
+    }
+    ingest_latest(&veiculo);
+    marcar_mudanca(veiculo.t_us);
+    gpio_put(LED_VERDE, veiculo.flags & INGEST_FLAG_MM);
+    gpio_put(LED_AZUL, veiculo.fuel <= 50 && veiculo.fuel > 20);
+    gpio_put(LED_VERMELHO, veiculo.fuel <= 20);
+}
+
+// Retrato a partir dos dados do veículo; com os dados velhos a velocidade some
+static painel_estado_t estado_veiculo(uint32_t agora) {
+    uint32_t velocidade = (veiculo.speed + 5) / 10;
+    painel_estado_t estado = {
+      .contador = agora - veiculo.t_us > VEICULO_VALIDADE_US ? -1 : velocidade > 999 ? 999 : (int)velocidade,
+      .mm_on = veiculo.flags & INGEST_FLAG_MM,
+      .gas_5l = veiculo.fuel <= 50 && veiculo.fuel > 20,
+      .gas_2l = veiculo.fuel <= 20,
+    };
+    return estado;
+}
+
+// Publica o estado do painel para o núcleo 1 quando ele muda. Com a fila
+// cheia o retrato fica para o próximo período, sem esperar
+static void executar_estado(void *arg) {
+    (void)arg;
+    static painel_estado_t publicado;
+    static bool publicou = false;
+    painel_estado_t estado = veiculo.seq ? estado_veiculo(time_us_32()) : capturar_estado(contador);
+    if (publicou && estado_igual(&estado, &publicado)) {
+      mudanca_marcada = false; // A causa não mudou o que o display mostra
+      return;
+    }
+    estado.t_us = mudanca_marcada ? mudanca_us : time_us_32();
+    if (spsc_queue_push(&fila_estados, &estado)) {
+      publicado = estado;
+      publicou = true;
+      mudanca_marcada = false;
+    }
+}
+
+static void executar_velocidade(void *arg) {
+    (void)arg;
+    if (veiculo.seq) {
+      return; // O controlador assumiu a velocidade
+    }
+    marcar_mudanca(time_us_32());
+    contador++;
+    if (contador > 100) {  
+      contador = 0;                
+    }
+}
+
+// Mostra os contadores das tarefas quando algum prazo foi perdido
+static void executar_estatisticas(void *arg) {
+    (void)arg;
+    static uint32_t falhas_anteriores = 0;
+    scheduler_task_t *tarefas[] = {&tarefa_entradas, &tarefa_joystick, &tarefa_matriz, &tarefa_veiculo, &tarefa_estado, &tarefa_velocidade};
+    const ingest_stats_t *recepcao = ingest_stats();
+    uint32_t falhas = fila_estados.dropped + input_dropped() + recepcao->crc_errors + recepcao->lost + recepcao->overruns;
+    for (uint i = 0; i < count_of(tarefas); ++i) {
+      falhas += tarefas[i]->overruns + tarefas[i]->missed;
+    }
+    // Núcleo 1 escreve, este só lê: os números podem estar um envio atrasados
+    for (uint i = 0; i < 2; ++i) {
+      const i2c_bus_stats_t *barramento = i2c_bus_stats(i ? i2c1 : i2c0);
+      falhas += barramento->timeouts + barramento->stuck;
+    }
+    for (uint i = 0; i < paineis.n_panels; ++i) {
+      falhas += paineis.panels[i]->stats.errors;
+    }
+    if (falhas != falhas_anteriores) {
+      falhas_anteriores = falhas;
+      scheduler_print_stats();
+      printf("fila_estados,descartes=%lu\n", (unsigned long)fila_estados.dropped);
+      printf("fila_entradas,descartes=%lu\n", (unsigned long)input_dropped());
+      printf("veiculo,quadros=%lu,crc=%lu,ignorados=%lu,perdidos=%lu,transbordos=%lu\n",
+             (unsigned long)recepcao->frames, (unsigned long)recepcao->crc_errors, (unsigned long)recepcao->skipped,
+             (unsigned long)recepcao->lost, (unsigned long)recepcao->overruns);
+      for (uint i = 0; i < 2; ++i) {
+        const i2c_bus_stats_t *b = i2c_bus_stats(i ? i2c1 : i2c0);
+        printf("i2c%u,transacoes=%lu,nacks=%lu,prazos=%lu,repeticoes=%lu,recuperacoes=%lu,travado=%lu,max_us=%lu,envios_dma=%lu,max_dma_us=%lu\n",
+               i, (unsigned long)b->transactions, (unsigned long)b->nacks, (unsigned long)b->timeouts,
+               (unsigned long)b->retries, (unsigned long)b->recoveries, (unsigned long)b->stuck,
+               (unsigned long)b->max_us, (unsigned long)b->dma_transfers, (unsigned long)b->max_dma_us);
+      }
+      for (uint i = 0; i < paineis.n_panels; ++i) {
+        const ssd1306_t *ssd = paineis.panels[i];
+        printf("oled%u_%02x,erros=%lu,reconfiguracoes=%lu,descartados=%lu,fora_do_ar=%d\n",
+               i2c_hw_index(ssd->i2c_port), ssd->address, (unsigned long)ssd->stats.errors,
+               (unsigned long)ssd->stats.reinits, (unsigned long)ssd->stats.skipped, ssd->offline);
+      }
+#if TRACE_ENABLED
+      printf("gravacao,descartes=%lu\n", (unsigned long)trace_dropped());
+#endif
+      fflush(stdout);
+    }
+}
+
+#if TRACE_ENABLED
+static scheduler_task_t tarefa_gravacao;
+
+// Exporta as entradas gravadas para reprodução em host (painel_host --replay)
+static void executar_gravacao(void *arg) {
+    (void)arg;
+    trace_flush();
+    fflush(stdout);
+}
+#endif
+
+#if TELEMETRY_ENABLED
+static scheduler_task_t tarefa_telemetria;
+
+// Drena os registros dos dois núcleos; a cada TELEMETRIA_EXPORTAR vezes exporta os histogramas
+static void executar_telemetria(void *arg) {
+    (void)arg;
+    static uint drenagens = 0;
+    if (++drenagens < TELEMETRIA_EXPORTAR) {
+      telemetry_drain();
+      return;
+    }
+    drenagens = 0;
+    telemetry_print();
+    fflush(stdout);
+}
+
+// Interrupção do alarme da matriz, no núcleo 0
+static void quadro_travado(led_matrix_t *m, void *arg) {
+    (void)m;
+    (void)arg;
+    if (quadro_medir) {
+      quadro_medir = false;
+      TELEMETRY_RECORD(LATENCIA_MATRIZ, time_us_32() - quadro_us);
+    }
+}
+
+// Interrupção do DMA do display, no núcleo 1 (ou direto, no envio de região)
+static void envio_concluido(ssd1306_t *ssd, void *arg) {
+    (void)ssd;
+    (void)arg;
+    uint32_t agora = time_us_32();
+    TELEMETRY_RECORD(ETAPA_BARRAMENTO, agora - envio_inicio_us);
+    TELEMETRY_RECORD(LATENCIA_OLED, agora - envio_estado_us);
+}
+#endif
+
+// Laço do núcleo 1: desenha o retrato mais recente e o envia por DMA. Se o
+// envio anterior ainda corre, o quadro fica pendente até um evento deste
+// núcleo: o fim do DMA acorda antes de a FIFO do I2C esvaziar, mas a vigia do
+// barramento (alarme no pool deste núcleo) dispara até o barramento parar, e
+// só então o grupo fica livre. Nenhuma dessas esperas depende do núcleo 0
+static void nucleo1_main(void) {
+    // Alarmes do driver (vigia do barramento) neste núcleo, o dono do estado dos envios
+    ssd1306_set_alarm_pool(alarm_pool_create_with_unused_hardware_alarm(SSD1306_ALARMS));
+    init_display(); // Inicializa o display; a DMA_IRQ_1 fica habilitada neste núcleo
+
+    // Exibição inicial no display OLED
+    ssd1306_fill(&display, !color); // Limpa o display preenchendo com a cor oposta ao valor atual de "color"
+    ssd1306_rect(&display, 3, 3, 122, 58, color, !color); // Desenha um retângulo com bordas dentro das coordenadas especificadas
+    ssd1306_send_data(&display); // Envia os dados para atualizar o display
+#if TELEMETRY_ENABLED
+    ssd1306_set_flush_callback(&display, envio_concluido, NULL);
+#endif
+
+    painel_estado_t estado;
+    uint8_t pendente = 0; // Widgets redesenhados e ainda não enviados
+    uint32_t pendente_us = 0; // Causa mais antiga do que está pendente
+    while (true) {
+      // Retratos que chegaram durante o envio anterior são descartados: só o último importa
+      if (spsc_queue_pop_latest(&fila_estados, &estado)) {
+        uint8_t mudou = 0;
+        TELEMETRY_SCOPE(ETAPA_DESENHO) {
+          mudou = desenhar_painel(color, &estado);
+        }
+        if (mudou && !pendente) {
+          pendente_us = estado.t_us;
+        }
+        pendente |= mudou;
+      }
+      // Sem envio em andamento, nenhuma interrupção de fim lê os instantes abaixo
+      if (pendente && !ssd1306_group_busy(&paineis)) {
+        envio_inicio_us = time_us_32();
+        envio_estado_us = pendente_us;
+        TELEMETRY_SCOPE(ETAPA_ENVIO) {
+          enviar_painel(pendente);
+        }
+        pendente = 0;
+      }
+      __wfe(); // Acorda com __sev() do núcleo 0, com a DMA_IRQ_1 ou com os alarmes do display
+    }
+}
+
+int main() {
+    init_matrix(MATRIX_PIN); // Configura controle na matriz
+    stdio_init_all(); // Inicializa a biblioteca padrão da Pico
+    init_leds();
+    init_buttons(notificar_entradas, &tarefa_entradas); // Eventos dos botões A, B e do joystick
+    joystick_init(NULL); // Amostragem contínua dos eixos X (pino 26) e Y (pino 27)
+    ingest_init(&(ingest_config_t){VEICULO_UART, VEICULO_RX_PIN, VEICULO_BAUD}); // Quadros do veículo por DMA
+
+    matrix_anim_init(&animacao, &matriz, DURACAO_TRANSICAO_US, 1000000 / PERIODO_MATRIZ_US);
+    telemetry_init(nomes_etapas, ETAPA_COUNT);
+#if TELEMETRY_ENABLED
+    matrix_set_latch_callback(&matriz, quadro_travado, NULL);
+#endif
+    spsc_queue_init(&fila_estados, estados, sizeof(painel_estado_t), FILA_ESTADOS_TAMANHO);
+    multicore_launch_core1(nucleo1_main); // Display e I2C ficam no núcleo 1
+
+    // Desliga todos os LEDs inicialmente
+    gpio_put(LED_VERDE, 0);
+    gpio_put(LED_AZUL, 0);
+    gpio_put(LED_VERMELHO, 0);
+
+    // Em ordem de prioridade; o prazo padrão é o próprio período
+    scheduler_task_init(&tarefa_entradas, "entradas", executar_entradas, NULL, 0, PERIODO_JOYSTICK_US);
+    scheduler_task_init(&tarefa_joystick, "joystick", executar_joystick, NULL, PERIODO_JOYSTICK_US, 0);
+    scheduler_task_init(&tarefa_matriz, "matriz", executar_matriz, NULL, PERIODO_MATRIZ_US, 0);
+    scheduler_task_init(&tarefa_veiculo, "veiculo", executar_veiculo, NULL, PERIODO_VEICULO_US, 0);
+    scheduler_task_init(&tarefa_estado, "estado", executar_estado, NULL, PERIODO_ESTADO_US, 0);
+    scheduler_task_init(&tarefa_velocidade, "velocidade", executar_velocidade, NULL, PERIODO_VELOCIDADE_US, 0);
+    scheduler_task_init(&tarefa_estatisticas, "estatisticas", executar_estatisticas, NULL, PERIODO_ESTATISTICAS_US, 0);
+    scheduler_add(&tarefa_entradas);
+    scheduler_add(&tarefa_joystick);
+    scheduler_add(&tarefa_matriz);
+    scheduler_add(&tarefa_veiculo);
+    scheduler_add(&tarefa_estado);
+    scheduler_add(&tarefa_velocidade);
+    scheduler_add(&tarefa_estatisticas);
+#if TELEMETRY_ENABLED
+    scheduler_task_init(&tarefa_telemetria, "coleta", executar_telemetria, NULL, PERIODO_TELEMETRIA_US, 0);
+    scheduler_add(&tarefa_telemetria);
+#endif
+#if TRACE_ENABLED
+    scheduler_task_init(&tarefa_gravacao, "gravacao", executar_gravacao, NULL, PERIODO_GRAVACAO_US, 0);
+    scheduler_add(&tarefa_gravacao);
+#endif
+
+    scheduler_run(); // Não retorna: executa as tarefas do núcleo 0 e dorme em __wfe entre eventos
+}
+#endif
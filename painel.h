@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ssd1306.h"
+#include "led_matrix.h"
+#include "setas.h"
+#include "input.h"
+
+// Estado e rotinas do painel usados fora de painel.c (bench.c)
+
+extern ssd1306_t display;
+extern ssd1306_group_t paineis; // display e os auxiliares detectados
+extern led_matrix_t matriz;
+
+void init_leds();
+void init_display();
+void init_buttons(input_notify_fn_t notify, void *arg);
+void init_matrix(uint pin);
+
+void tratar_entrada(const input_event_t *evento);
+
+void update_leds();
+void turn_off_leds();
+direcao_t classificar_direcao(int16_t eixo_x, int16_t eixo_y);
+void atualizar_matriz(int16_t *eixo_x, int16_t *eixo_y);
+uint32_t ler_joystick(int16_t *eixo_x, int16_t *eixo_y);
+
+// Retrato imutável do que o display mostra, montado no núcleo 0 e entregue ao
+// núcleo 1, dono do display
+typedef struct {
+    int contador;  // Velocidade em km/h
+    bool mm_on;    // LED verde aceso
+    bool gas_5l;   // LED azul aceso
+    bool gas_2l;   // LED vermelho aceso
+    uint32_t t_us; // Causa mais antiga da mudança (telemetria; ignorado por estado_igual)
+} painel_estado_t;
+
+painel_estado_t capturar_estado(int contador);
+bool estado_igual(const painel_estado_t *a, const painel_estado_t *b);
+// Widgets redesenhados por desenhar_painel (máscara de bits)
+enum {
+    PAINEL_BORDA = 1u << 0,
+    PAINEL_MODO = 1u << 1,
+    PAINEL_VELOCIDADE = 1u << 2,
+    PAINEL_COMBUSTIVEL = 1u << 3,
+    PAINEL_AUXILIARES = 1u << 4, // Algum widget dos displays auxiliares
+};
+
+uint8_t desenhar_painel(bool color, const painel_estado_t *estado);
+bool enviar_painel(uint8_t mudou);
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <string.h>
+#include "scheduler.h"
+#include "hardware/sync.h"
+
+static scheduler_task_t *tasks[SCHEDULER_MAX_TASKS];
+static uint n_tasks;
+
+// Marca a tarefa como pronta; chamada também de interrupções
+static void scheduler_release(scheduler_task_t *task) {
+  if (task->ready) {
+    ++task->missed;
+  } else {
+    task->release_us = time_us_64();
+    task->ready = true;
+  }
+  __sev();
+}
+
+static bool scheduler_timer_cb(repeating_timer_t *rt) {
+  scheduler_release(rt->user_data);
+  return true;
+}
+
+void scheduler_task_init(scheduler_task_t *task, const char *name, scheduler_fn_t fn, void *arg,
+                         uint32_t period_us, uint32_t deadline_us) {
+  memset(task, 0, sizeof(*task));
+  task->name = name;
+  task->fn = fn;
+  task->arg = arg;
+  task->period_us = period_us;
+  task->deadline_us = deadline_us ? deadline_us : period_us;
+}
+
+// Registra a tarefa e, se periódica, arma o timer (intervalo entre inícios, sem deriva)
+bool scheduler_add(scheduler_task_t *task) {
+  if (n_tasks == SCHEDULER_MAX_TASKS)
+    return false;
+  tasks[n_tasks++] = task;
+  if (task->period_us)
+    return add_repeating_timer_us(-(int64_t)task->period_us, scheduler_timer_cb, task, &task->timer);
+  return true;
+}
+
+void scheduler_post(scheduler_task_t *task) {
+  scheduler_release(task);
+}
+
+// Executa a tarefa pronta de maior prioridade; falso se nenhuma estava pronta
+bool scheduler_run_pending(void) {
+  for (uint i = 0; i < n_tasks; ++i) {
+    scheduler_task_t *task = tasks[i];
+    if (!task->ready)
+      continue;
+    uint64_t release = task->release_us;
+    task->ready = false;
+    uint64_t start = time_us_64();
+    task->fn(task->arg);
+    uint64_t end = time_us_64();
+
+    uint32_t elapsed = end - start;
+    ++task->runs;
+    task->total_us += elapsed;
+    if (elapsed > task->max_us)
+      task->max_us = elapsed;
+    if (task->deadline_us && end - release > task->deadline_us)
+      ++task->overruns;
+    return true;
+  }
+  return false;
+}
+
+// Laço principal: roda as tarefas prontas e dorme em __wfe até o próximo evento.
+// O __sev das liberações evita perder um evento entre a busca e o __wfe
+void scheduler_run(void) {
+  while (true) {
+    if (!scheduler_run_pending())
+      __wfe();
+  }
+}
+
+void scheduler_print_stats(void) {
+  printf("tarefa,execucoes,estouros,perdidas,max_us,media_us\n");
+  for (uint i = 0; i < n_tasks; ++i) {
+    const scheduler_task_t *task = tasks[i];
+    printf("%s,%lu,%lu,%lu,%lu,%lu\n", task->name, (unsigned long)task->runs, (unsigned long)task->overruns,
+           (unsigned long)task->missed, (unsigned long)task->max_us,
+           (unsigned long)(task->runs ? task->total_us / task->runs : 0));
+  }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+#define SCHEDULER_MAX_TASKS 10
+
+typedef void (*scheduler_fn_t)(void *arg);
+
+// Tarefa cooperativa: roda até o fim no laço principal quando liberada pelo
+// seu timer periódico ou por scheduler_post(). A ordem de inclusão é a
+// prioridade: após cada execução a busca recomeça pela primeira tarefa.
+typedef struct {
+  const char *name;
+  scheduler_fn_t fn;
+  void *arg;
+  uint32_t period_us;   // 0 para tarefas liberadas só por scheduler_post()
+  uint32_t deadline_us; // Prazo a partir da liberação (0 = o próprio período)
+
+  repeating_timer_t timer;
+  volatile bool ready;
+  volatile uint64_t release_us; // Instante da liberação pendente
+
+  uint32_t runs;
+  uint32_t overruns; // Execuções terminadas depois do prazo
+  uint32_t missed;   // Liberações perdidas por a anterior ainda não ter rodado
+  uint32_t max_us;   // Maior tempo de execução
+  uint64_t total_us;
+} scheduler_task_t;
+
+void scheduler_task_init(scheduler_task_t *task, const char *name, scheduler_fn_t fn, void *arg,
+                         uint32_t period_us, uint32_t deadline_us);
+bool scheduler_add(scheduler_task_t *task);
+void scheduler_post(scheduler_task_t *task);
+bool scheduler_run_pending(void);
+void scheduler_run(void) __attribute__((noreturn)); // Laço principal do núcleo 0
+void scheduler_print_stats(void);
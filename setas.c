@@ -0,0 +1,77 @@
+#include "setas.h"
+
+#define SETA_COR MATRIX_GRB(0, 0, 255)
+
+// Uma linha do desenho, da esquerda para a direita, 1 = aceso
+#define LINHA(row, c0, c1, c2, c3, c4)              \
+  [LED_MATRIX_INDEX(row, 0)] = (c0) ? SETA_COR : 0, \
+  [LED_MATRIX_INDEX(row, 1)] = (c1) ? SETA_COR : 0, \
+  [LED_MATRIX_INDEX(row, 2)] = (c2) ? SETA_COR : 0, \
+  [LED_MATRIX_INDEX(row, 3)] = (c3) ? SETA_COR : 0, \
+  [LED_MATRIX_INDEX(row, 4)] = (c4) ? SETA_COR : 0
+
+const uint32_t setas[DIRECAO_COUNT][LED_MATRIX_NUM_LEDS] = {
+  [DIRECAO_CENTRO] = {
+    LINHA(0, 0, 0, 0, 0, 0),
+    LINHA(1, 0, 1, 1, 1, 0),
+    LINHA(2, 0, 1, 0, 1, 0),
+    LINHA(3, 0, 1, 1, 1, 0),
+    LINHA(4, 0, 0, 0, 0, 0),
+  },
+  [DIRECAO_DIREITA] = {
+    LINHA(0, 0, 0, 1, 0, 0),
+    LINHA(1, 0, 0, 0, 1, 0),
+    LINHA(2, 1, 1, 1, 1, 1),
+    LINHA(3, 0, 0, 0, 1, 0),
+    LINHA(4, 0, 0, 1, 0, 0),
+  },
+  [DIRECAO_CIMA_DIREITA] = {
+    LINHA(0, 0, 0, 1, 1, 1),
+    LINHA(1, 0, 0, 0, 1, 1),
+    LINHA(2, 0, 0, 1, 0, 1),
+    LINHA(3, 0, 1, 0, 0, 0),
+    LINHA(4, 1, 0, 0, 0, 0),
+  },
+  [DIRECAO_BAIXO_DIREITA] = {
+    LINHA(0, 1, 0, 0, 0, 0),
+    LINHA(1, 0, 1, 0, 0, 0),
+    LINHA(2, 0, 0, 1, 0, 1),
+    LINHA(3, 0, 0, 0, 1, 1),
+    LINHA(4, 0, 0, 1, 1, 1),
+  },
+  [DIRECAO_CIMA] = {
+    LINHA(0, 0, 0, 1, 0, 0),
+    LINHA(1, 0, 1, 1, 1, 0),
+    LINHA(2, 0, 0, 1, 0, 0),
+    LINHA(3, 0, 0, 1, 0, 0),
+    LINHA(4, 0, 0, 1, 0, 0),
+  },
+  [DIRECAO_BAIXO] = {
+    LINHA(0, 0, 0, 1, 0, 0),
+    LINHA(1, 0, 0, 1, 0, 0),
+    LINHA(2, 0, 0, 1, 0, 0),
+    LINHA(3, 0, 1, 1, 1, 0),
+    LINHA(4, 0, 0, 1, 0, 0),
+  },
+  [DIRECAO_CIMA_ESQUERDA] = {
+    LINHA(0, 1, 1, 1, 0, 0),
+    LINHA(1, 1, 1, 0, 0, 0),
+    LINHA(2, 1, 0, 1, 0, 0),
+    LINHA(3, 0, 0, 0, 1, 0),
+    LINHA(4, 0, 0, 0, 0, 1),
+  },
+  [DIRECAO_ESQUERDA] = {
+    LINHA(0, 0, 0, 1, 0, 0),
+    LINHA(1, 0, 1, 0, 0, 0),
+    LINHA(2, 1, 1, 1, 1, 1),
+    LINHA(3, 0, 1, 0, 0, 0),
+    LINHA(4, 0, 0, 1, 0, 0),
+  },
+  [DIRECAO_BAIXO_ESQUERDA] = {
+    LINHA(0, 0, 0, 0, 0, 1),
+    LINHA(1, 0, 0, 0, 1, 0),
+    LINHA(2, 1, 0, 1, 0, 0),
+    LINHA(3, 1, 1, 0, 0, 0),
+    LINHA(4, 1, 1, 1, 0, 0),
+  },
+};
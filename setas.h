@@ -0,0 +1,21 @@
+#pragma once
+
+#include "led_matrix.h"
+
+// Direções do joystick, nomeadas pela seta que a matriz mostra
+typedef enum {
+  DIRECAO_CENTRO = 0,
+  DIRECAO_DIREITA,
+  DIRECAO_CIMA_DIREITA,
+  DIRECAO_BAIXO_DIREITA,
+  DIRECAO_CIMA,
+  DIRECAO_BAIXO,
+  DIRECAO_CIMA_ESQUERDA,
+  DIRECAO_ESQUERDA,
+  DIRECAO_BAIXO_ESQUERDA,
+  DIRECAO_COUNT,
+  DIRECAO_INDEFINIDA = DIRECAO_COUNT // Nenhuma direção lida ainda
+} direcao_t;
+
+// Quadros já na ordem dos LEDs da fita e empacotados em GRB, prontos para matrix_show_frame
+extern const uint32_t setas[DIRECAO_COUNT][LED_MATRIX_NUM_LEDS];
@@ -0,0 +1,61 @@
+#include <string.h>
+#include "spsc_queue.h"
+#include "hardware/sync.h"
+
+// Os índices correm livres e são reduzidos pela máscara só no acesso; head - tail
+// é o nível mesmo depois de darem a volta. capacity tem de ser potência de 2
+void spsc_queue_init(spsc_queue_t *q, void *storage, uint32_t elem_size, uint32_t capacity) {
+  q->storage = storage;
+  q->elem_size = elem_size;
+  q->capacity = capacity;
+  q->head = 0;
+  q->tail = 0;
+  q->dropped = 0;
+}
+
+// Copia o elemento para a fila; false (e conta a perda) se ela estiver cheia.
+// Só o núcleo produtor chama
+bool spsc_queue_push(spsc_queue_t *q, const void *elem) {
+  uint32_t head = q->head;
+  if (head - q->tail == q->capacity) {
+    ++q->dropped;
+    return false;
+  }
+  memcpy(q->storage + (head & (q->capacity - 1)) * q->elem_size, elem, q->elem_size);
+  // O elemento tem de estar visível antes do novo head
+  __dmb();
+  q->head = head + 1;
+  __sev();
+  return true;
+}
+
+// Retira o elemento mais antigo; false se a fila estiver vazia. Só o núcleo
+// consumidor chama
+bool spsc_queue_pop(spsc_queue_t *q, void *elem) {
+  uint32_t tail = q->tail;
+  if (q->head == tail)
+    return false;
+  __dmb();
+  memcpy(elem, q->storage + (tail & (q->capacity - 1)) * q->elem_size, q->elem_size);
+  // A cópia termina antes de liberar a posição para o produtor
+  __dmb();
+  q->tail = tail + 1;
+  return true;
+}
+
+// Esvazia a fila ficando só com o elemento mais recente
+bool spsc_queue_pop_latest(spsc_queue_t *q, void *elem) {
+  uint32_t head = q->head;
+  uint32_t tail = q->tail;
+  if (head == tail)
+    return false;
+  __dmb();
+  memcpy(elem, q->storage + ((head - 1) & (q->capacity - 1)) * q->elem_size, q->elem_size);
+  __dmb();
+  q->tail = head;
+  return true;
+}
+
+uint32_t spsc_queue_level(const spsc_queue_t *q) {
+  return q->head - q->tail;
+}
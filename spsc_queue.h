@@ -0,0 +1,22 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+// Fila sem trava de um produtor e um consumidor, para passar dados entre os
+// núcleos. Elementos de tamanho fixo são copiados para dentro e para fora do
+// armazenamento fornecido pelo chamador; só o produtor escreve head e só o
+// consumidor escreve tail, então nenhum lado espera pelo outro.
+typedef struct {
+  uint8_t *storage;
+  uint32_t elem_size;
+  uint32_t capacity;      // Potência de 2
+  volatile uint32_t head; // Próxima posição a escrever (produtor)
+  volatile uint32_t tail; // Próxima posição a ler (consumidor)
+  uint32_t dropped;       // Inserções recusadas com a fila cheia (produtor)
+} spsc_queue_t;
+
+void spsc_queue_init(spsc_queue_t *q, void *storage, uint32_t elem_size, uint32_t capacity);
+bool spsc_queue_push(spsc_queue_t *q, const void *elem);
+bool spsc_queue_pop(spsc_queue_t *q, void *elem);
+bool spsc_queue_pop_latest(spsc_queue_t *q, void *elem);
+uint32_t spsc_queue_level(const spsc_queue_t *q);
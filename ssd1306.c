@@ -1,120 +1,948 @@
+#include <string.h>
 #include "ssd1306.h"
-#include "font.h"
+#include "fonts.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 
-void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
+// Custo em bytes no barramento de uma janela SET_COL_ADDR/SET_PAGE_ADDR: uma
+// transação com endereço, byte de controle 0x00 (Co=0, só comandos) e os seis bytes
+#define SSD1306_WINDOW_COST (2 + 6)
+// Custo fixo de cada transação de dados (endereço + byte de controle 0x40)
+#define SSD1306_DATA_COST 2
+// Transações de teste em ssd1306_probe_baudrate
+#define SSD1306_PROBE_WRITES 4
+
+// Palavra de 32 bits que pode apelidar o buffer de bytes
+typedef uint32_t __attribute__((__may_alias__)) ssd1306_word_t;
+
+// Preâmbulo de janela pronto para o DMA; só colunas e páginas são preenchidas a cada envio
+static const uint16_t window_preamble[SSD1306_WINDOW_WORDS] = {
+  0x00, SET_COL_ADDR, 0, 0, SET_PAGE_ADDR, 0, I2C_IC_DATA_CMD_STOP_BITS,
+};
+
+// Sequência de inicialização enviada numa única transação: o byte de controle
+// 0x00 (Co=0) faz o controlador tratar todos os bytes seguintes como comandos.
+// Os argumentos de SET_MUX_RATIO e SET_COM_PIN_CFG (nas posições abaixo) são
+// os da geometria fixa ou, sem ela, trocados pelos de cada painel
+#define SSD1306_INIT_MUX_ARG 7
+#define SSD1306_INIT_COM_PIN_ARG 12
+#define SSD1306_COM_PINS(height) ((height) > 32 ? 0x12 : 0x02) // COM alternados só nos de 64 linhas
+static const uint8_t init_sequence[] = {
+  0x00,
+  SET_DISP | 0x00,
+  SET_MEM_ADDR, 0x00, // Endereçamento horizontal: cada página é uma linha contígua do buffer
+  SET_DISP_START_LINE | 0x00,
+  SET_SEG_REMAP | 0x01,
+  SET_MUX_RATIO, HEIGHT - 1,
+  SET_COM_OUT_DIR | 0x08,
+  SET_DISP_OFFSET, 0x00,
+  SET_COM_PIN_CFG, SSD1306_COM_PINS(HEIGHT),
+  SET_DISP_CLK_DIV, 0x80,
+  SET_PRECHARGE, 0xF1,
+  SET_VCOM_DESEL, 0x30,
+  SET_CONTRAST, 0xFF,
+  SET_ENTIRE_ON,
+  SET_NORM_INV,
+  SET_CHARGE_PUMP, 0x14,
+  SET_DISP | 0x01,
+};
+
+// Máscaras de página: bits da linha n até o fim do byte e do início até a linha n
+static const uint8_t mask_from[8] = {0xFF, 0xFE, 0xFC, 0xF8, 0xF0, 0xE0, 0xC0, 0x80};
+static const uint8_t mask_to[8] = {0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F, 0xFF};
+
+// Instâncias atendidas pelo tratador compartilhado de DMA_IRQ_1. A linha 1 fica
+// para o display para que ele possa ser atendido por um núcleo diferente do que
+// trata a DMA_IRQ_0 (matriz de LEDs e joystick): cada núcleo habilita só a sua
+static ssd1306_t *dma_panels[SSD1306_MAX_PANELS];
+// Painel cujo DMA ocupa cada controlador I2C
+static ssd1306_t *volatile bus_active[SSD1306_MAX_BUSES];
+// Último painel a transmitir por DMA em cada controlador, até o aborto (NACK)
+// do envio dele ser verificado
+static ssd1306_t *volatile bus_check[SSD1306_MAX_BUSES];
+// Prazo do último envio por DMA em cada controlador, vigiado por um alarme
+static volatile uint32_t bus_deadline[SSD1306_MAX_BUSES];
+static alarm_id_t bus_watch[SSD1306_MAX_BUSES];
+// Pool dos alarmes do driver (ssd1306_set_alarm_pool); sem ele, o padrão
+static alarm_pool_t *alarm_pool;
+
+static void ssd1306_group_done(ssd1306_t *ssd);
+static void ssd1306_bus_watch_in(i2c_inst_t *i2c, uint32_t delay_us);
+
+static inline bool ssd1306_expired(uint32_t deadline_us) {
+  return (int32_t)(time_us_32() - deadline_us) >= 0;
+}
+
+// Painel que parou de responder: o conteúdo da GDDRAM passa a ser
+// desconhecido e os envios são descartados até ssd1306_config voltar a
+// funcionar, tentada primeiro depois de SSD1306_REINIT_MIN_US e, a cada nova
+// falha, com o dobro da espera, até SSD1306_REINIT_MAX_US. Também chamada da
+// interrupção (NACK de um envio por DMA)
+static void ssd1306_fault(ssd1306_t *ssd, i2c_bus_status_t status) {
+  ssd->stats.errors++;
+  ssd->last_error = status;
+  ssd->front_valid = false;
+  if (!ssd->offline) {
+    ssd->offline = true;
+    ssd->retry_delay_us = SSD1306_REINIT_MIN_US;
+  } else {
+    ssd->retry_delay_us *= 2;
+    if (ssd->retry_delay_us > SSD1306_REINIT_MAX_US)
+      ssd->retry_delay_us = SSD1306_REINIT_MAX_US;
+  }
+  ssd->retry_at_us = time_us_32() + ssd->retry_delay_us;
+}
+
+static void ssd1306_dma_irq_handler(void) {
+  for (uint i = 0; i < SSD1306_MAX_PANELS; ++i) {
+    ssd1306_t *ssd = dma_panels[i];
+    if (ssd && dma_channel_get_irq1_status(ssd->dma_channel)) {
+      dma_channel_acknowledge_irq1(ssd->dma_channel);
+      i2c_bus_record_dma(ssd->i2c_port, time_us_32() - ssd->tx_start_us);
+      ssd->busy = false;
+      bus_active[i2c_hw_index(ssd->i2c_port)] = NULL;
+      // Os últimos bytes ainda estão na FIFO: o alarme confere o aborto quando ela esvaziar
+      ssd1306_bus_watch_in(ssd->i2c_port, SSD1306_BUS_RETRY_US);
+      if (ssd->flush_cb)
+        ssd->flush_cb(ssd, ssd->flush_cb_arg);
+      if (ssd->group)
+        ssd1306_group_done(ssd);
+    }
+  }
+}
+
+// Reserva um canal de DMA que alimenta a FIFO de transmissão do I2C com palavras de 16 bits
+static void ssd1306_dma_init(ssd1306_t *ssd) {
+  static bool irq_installed = false;
+  ssd->dma_channel = dma_claim_unused_channel(true);
+  dma_channel_config c = dma_channel_get_default_config(ssd->dma_channel);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_dreq(&c, i2c_get_dreq(ssd->i2c_port, true));
+  dma_channel_configure(ssd->dma_channel, &c, &i2c_get_hw(ssd->i2c_port)->data_cmd, ssd->tx_stream, 0, false);
+
+  for (uint i = 0; i < SSD1306_MAX_PANELS; ++i) {
+    if (!dma_panels[i]) {
+      dma_panels[i] = ssd;
+      break;
+    }
+  }
+  dma_channel_set_irq1_enabled(ssd->dma_channel, true);
+  if (!irq_installed) {
+    irq_add_shared_handler(DMA_IRQ_1, ssd1306_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+    irq_installed = true;
+  }
+}
+
+// ram tem 3 bytes a mais e alinhamento de 32 bits: o byte de controle fica em
+// ram[3], para que os dados, a partir de ram_buffer[1], fiquem alinhados para
+// as rotinas de varredura
+static void ssd1306_setup(ssd1306_t *ssd, uint8_t width, uint8_t height, uint8_t *ram, uint8_t *front, uint16_t *tx,
+                          bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
   ssd->width = width;
   ssd->height = height;
   ssd->pages = height / 8U;
   ssd->address = address;
   ssd->i2c_port = i2c;
-  ssd->bufsize = ssd->pages * ssd->width + 1;
-  ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
+  ssd->external_vcc = external_vcc;
+  ssd->ram_buffer = ram + 3;
   ssd->ram_buffer[0] = 0x40;
+  ssd->front_buffer = front;
+  ssd->front_valid = false;
   ssd->port_buffer[0] = 0x80;
+  ssd->tx_capacity = SSD1306_TX_WORDS(width, height);
+  ssd->tx_stream = tx;
+  ssd->tx_len = 0;
+  ssd->busy = false;
+  ssd->flush_cb = NULL;
+  ssd->flush_cb_arg = NULL;
+  ssd->group = NULL;
+  ssd->queued = false;
+  ssd->offline = false;
+  ssd->last_error = I2C_BUS_OK;
+  memset(&ssd->stats, 0, sizeof(ssd->stats));
+  ssd1306_invalidate(ssd);
+  ssd1306_dma_init(ssd);
 }
 
-void ssd1306_config(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_DISP | 0x00);
-  ssd1306_command(ssd, SET_MEM_ADDR);
-  ssd1306_command(ssd, 0x01);
-  ssd1306_command(ssd, SET_DISP_START_LINE | 0x00);
-  ssd1306_command(ssd, SET_SEG_REMAP | 0x01);
-  ssd1306_command(ssd, SET_MUX_RATIO);
-  ssd1306_command(ssd, HEIGHT - 1);
-  ssd1306_command(ssd, SET_COM_OUT_DIR | 0x08);
-  ssd1306_command(ssd, SET_DISP_OFFSET);
-  ssd1306_command(ssd, 0x00);
-  ssd1306_command(ssd, SET_COM_PIN_CFG);
-  ssd1306_command(ssd, 0x12);
-  ssd1306_command(ssd, SET_DISP_CLK_DIV);
-  ssd1306_command(ssd, 0x80);
-  ssd1306_command(ssd, SET_PRECHARGE);
-  ssd1306_command(ssd, 0xF1);
-  ssd1306_command(ssd, SET_VCOM_DESEL);
-  ssd1306_command(ssd, 0x30);
-  ssd1306_command(ssd, SET_CONTRAST);
-  ssd1306_command(ssd, 0xFF);
-  ssd1306_command(ssd, SET_ENTIRE_ON);
-  ssd1306_command(ssd, SET_NORM_INV);
-  ssd1306_command(ssd, SET_CHARGE_PUMP);
-  ssd1306_command(ssd, 0x14);
-  ssd1306_command(ssd, SET_DISP | 0x01);
-}
-
-void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
+// Buffers no heap, na geometria pedida (com SSD1306_FIXED_*, a da compilação)
+void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
+#ifdef SSD1306_FIXED_HEIGHT
+  width = SSD1306_FIXED_WIDTH;
+  height = SSD1306_FIXED_HEIGHT;
+#endif
+  size_t bufsize = SSD1306_BUFSIZE(width, height);
+  ssd1306_setup(ssd, width, height, calloc(bufsize + 3, sizeof(uint8_t)), calloc(bufsize, sizeof(uint8_t)),
+                calloc(SSD1306_TX_WORDS(width, height), sizeof(uint16_t)), external_vcc, address, i2c);
+}
+
+// Buffers estáticos declarados com SSD1306_STORAGE, sem uso do heap
+void ssd1306_init_static(ssd1306_t *ssd, const ssd1306_storage_t *storage, bool external_vcc, uint8_t address,
+                         i2c_inst_t *i2c) {
+  ssd1306_setup(ssd, storage->width, storage->height, storage->ram, storage->front, storage->tx, external_vcc,
+                address, i2c);
+}
+
+// Envia a sequência de inicialização. Se o painel não a aceitar, ele fica fora
+// do ar e é reconfigurado mais tarde pelos próprios envios
+bool ssd1306_config(ssd1306_t *ssd) {
+#ifdef SSD1306_FIXED_HEIGHT
+  const uint8_t *sequence = init_sequence; // Já na geometria da compilação
+#else
+  uint8_t sequence[sizeof(init_sequence)];
+  memcpy(sequence, init_sequence, sizeof(sequence));
+  sequence[SSD1306_INIT_MUX_ARG] = ssd->height - 1;
+  sequence[SSD1306_INIT_COM_PIN_ARG] = SSD1306_COM_PINS(ssd->height);
+#endif
+  ssd1306_flush_wait(ssd);
+
+  // Após a configuração o conteúdo da GDDRAM é indefinido: o próximo envio é completo
+  ssd->front_valid = false;
+  ssd1306_invalidate(ssd);
+  i2c_bus_status_t status = i2c_bus_write(ssd->i2c_port, ssd->address, sequence, sizeof(init_sequence));
+  if (status != I2C_BUS_OK) {
+    ssd1306_fault(ssd, status);
+    return false;
+  }
+  return true;
+}
+
+// Falso enquanto o painel estiver fora do ar. Vencida a espera, tenta
+// reconfigurá-lo (transações bloqueantes, cada uma com prazo)
+static bool ssd1306_ready(ssd1306_t *ssd) {
+  if (!ssd->offline)
+    return true;
+  if (!ssd1306_expired(ssd->retry_at_us) || !ssd1306_config(ssd))
+    return false;
+  ssd->offline = false;
+  ssd->stats.reinits++;
+  return true;
+}
+
+// Passa o barramento para baudrate e confirma que o painel continua
+// respondendo (ACK) a algumas transações de comando inofensivas (NOP). Se
+// alguma falhar, volta para fallback e retorna false. O RP2040 vai até 1 MHz
+// (Fast-mode Plus); muitos módulos SSD1306 aguentam, mas o datasheet só
+// garante 400 kHz e pull-ups fracos arredondam as bordas
+static bool ssd1306_nop(i2c_inst_t *i2c, uint8_t address) {
+  static const uint8_t nop[] = {0x00, 0xE3}; // Co=0 e o comando NOP
+  return i2c_bus_write(i2c, address, nop, sizeof(nop)) == I2C_BUS_OK;
+}
+
+bool ssd1306_probe_baudrate(ssd1306_t *ssd, uint baudrate, uint fallback) {
+  ssd1306_flush_wait(ssd);
+  i2c_bus_set_baudrate(ssd->i2c_port, baudrate);
+  for (uint i = 0; i < SSD1306_PROBE_WRITES; ++i) {
+    if (!ssd1306_nop(ssd->i2c_port, ssd->address)) {
+      i2c_bus_set_baudrate(ssd->i2c_port, fallback);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ssd1306_command(ssd1306_t *ssd, uint8_t command) {
+  ssd1306_flush_wait(ssd); // O controlador não pode ser reprogramado no meio de um envio
   ssd->port_buffer[1] = command;
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->port_buffer,
-    2,
-    false
-  );
+  i2c_bus_status_t status = i2c_bus_write(ssd->i2c_port, ssd->address, ssd->port_buffer, 2);
+  if (status != I2C_BUS_OK) {
+    ssd1306_fault(ssd, status);
+    return false;
+  }
+  return true;
 }
 
+// Recorta o retângulo (x0, y0)-(x1, y1), coordenadas inclusivas, à área do
+// painel. Retorna falso se nada sobrar.
+static inline bool ssd1306_clip(ssd1306_t *ssd, int *x0, int *y0, int *x1, int *y1) {
+  if (*x0 < 0)
+    *x0 = 0;
+  if (*y0 < 0)
+    *y0 = 0;
+  if (*x1 >= ssd1306_width(ssd))
+    *x1 = ssd1306_width(ssd) - 1;
+  if (*y1 >= ssd1306_height(ssd))
+    *y1 = ssd1306_height(ssd) - 1;
+  return *x0 <= *x1 && *y0 <= *y1;
+}
+
+static inline void ssd1306_mark_page(ssd1306_t *ssd, uint8_t page, uint8_t x0, uint8_t x1) {
+  if (x0 < ssd->dirty_x0[page])
+    ssd->dirty_x0[page] = x0;
+  if (x1 > ssd->dirty_x1[page])
+    ssd->dirty_x1[page] = x1;
+}
+
+// Marca como alterado o retângulo (x0, y0)-(x1, y1), coordenadas inclusivas
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+  if (x0 >= ssd1306_width(ssd) || y0 >= ssd1306_height(ssd) || x0 > x1 || y0 > y1)
+    return;
+  if (x1 >= ssd1306_width(ssd))
+    x1 = ssd1306_width(ssd) - 1;
+  if (y1 >= ssd1306_height(ssd))
+    y1 = ssd1306_height(ssd) - 1;
+  for (uint8_t page = y0 >> 3; page <= (y1 >> 3); ++page)
+    ssd1306_mark_page(ssd, page, x0, x1);
+}
+
+// Marca o quadro inteiro como alterado. O envio seguinte compara o buffer com
+// a cópia do último quadro enviado e transmite apenas o que de fato mudou, o que
+// serve de alternativa para quem escreve em ram_buffer diretamente.
+void ssd1306_invalidate(ssd1306_t *ssd) {
+  for (uint8_t page = 0; page < ssd1306_pages(ssd); ++page) {
+    ssd->dirty_x0[page] = 0;
+    ssd->dirty_x1[page] = ssd1306_width(ssd) - 1;
+  }
+}
+
+static inline bool ssd1306_page_dirty(ssd1306_t *ssd, uint8_t page) {
+  return ssd->dirty_x0[page] <= ssd->dirty_x1[page];
+}
+
+static inline void ssd1306_clear_dirty(ssd1306_t *ssd) {
+  for (uint8_t page = 0; page < SSD1306_MAX_PAGES; ++page) {
+    ssd->dirty_x0[page] = 0xFF;
+    ssd->dirty_x1[page] = 0;
+  }
+}
+
+// Reduz a faixa alterada de cada página descartando, nas extremidades, os
+// bytes que já são iguais ao buffer da frente
+static void ssd1306_trim_dirty(ssd1306_t *ssd) {
+  for (uint8_t page = 0; page < ssd1306_pages(ssd); ++page) {
+    if (!ssd1306_page_dirty(ssd, page))
+      continue;
+    const uint8_t *ram = &ssd->ram_buffer[page * ssd1306_width(ssd) + 1];
+    const uint8_t *front = &ssd->front_buffer[page * ssd1306_width(ssd) + 1];
+    int x0 = ssd->dirty_x0[page];
+    int x1 = ssd->dirty_x1[page];
+    while (x0 <= x1 && ram[x0] == front[x0])
+      ++x0;
+    while (x1 >= x0 && ram[x1] == front[x1])
+      --x1;
+    if (x0 > x1) {
+      ssd->dirty_x0[page] = 0xFF;
+      ssd->dirty_x1[page] = 0;
+    } else {
+      ssd->dirty_x0[page] = x0;
+      ssd->dirty_x1[page] = x1;
+    }
+  }
+}
+
+// Acrescenta ao fluxo a transação de comandos que programa a janela
+static inline void ssd1306_stream_preamble(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) {
+  uint16_t *out = &ssd->tx_stream[ssd->tx_len];
+  memcpy(out, window_preamble, sizeof(window_preamble));
+  out[2] = x0;
+  out[3] = x1;
+  out[5] = p0;
+  out[6] |= p1;
+  ssd->tx_len += SSD1306_WINDOW_WORDS;
+}
+
+// Acrescenta ao fluxo uma transação de dados com len bytes a partir de
+// ram_buffer[offset] e copia o trecho para o buffer da frente
+static uint32_t ssd1306_stream_span(ssd1306_t *ssd, size_t offset, size_t len) {
+  const uint8_t *src = &ssd->ram_buffer[offset];
+  uint16_t *out = &ssd->tx_stream[ssd->tx_len];
+  *out++ = 0x40;
+  for (size_t i = 0; i < len; ++i)
+    out[i] = src[i];
+  out[len - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+  ssd->tx_len += len + 1;
+  memcpy(&ssd->front_buffer[offset], src, len);
+  return len + SSD1306_DATA_COST;
+}
+
+// Programa a janela de colunas x0..x1 e páginas p0..p1 e envia seus dados. O
+// ponteiro de endereço do painel avança sozinho para a página seguinte ao
+// atingir x1, então basta uma janela e uma transação de dados por página (ou
+// uma só, quando a janela ocupa a largura inteira e as páginas são contíguas).
+static uint32_t ssd1306_stream_window(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t p0, uint8_t p1) {
+  uint32_t bytes = SSD1306_WINDOW_COST;
+  size_t span = x1 - x0 + 1;
+  ssd1306_stream_preamble(ssd, x0, x1, p0, p1);
+  if (span == ssd1306_width(ssd)) {
+    bytes += ssd1306_stream_span(ssd, p0 * ssd1306_width(ssd) + 1, span * (p1 - p0 + 1));
+  } else {
+    for (uint8_t page = p0; page <= p1; ++page)
+      bytes += ssd1306_stream_span(ssd, page * ssd1306_width(ssd) + x0 + 1, span);
+  }
+  return bytes;
+}
+
+void ssd1306_set_flush_callback(ssd1306_t *ssd, ssd1306_flush_cb_t cb, void *arg) {
+  ssd->flush_cb = cb;
+  ssd->flush_cb_arg = arg;
+}
+
+// Os alarmes do driver mexem no estado dos envios, que é do núcleo que
+// desenha e trata a DMA_IRQ_1: os callbacks precisam rodar nesse mesmo
+// núcleo, num pool criado por ele com SSD1306_ALARMS alarmes. Chamada antes
+// do primeiro envio; sem ela, vale o pool padrão (núcleo 0)
+void ssd1306_set_alarm_pool(alarm_pool_t *pool) {
+  alarm_pool = pool;
+}
+
+static inline alarm_pool_t *ssd1306_alarm_pool(void) {
+  return alarm_pool ? alarm_pool : alarm_pool_get_default();
+}
+
+// Controlador sem DMA de nenhum painel e com a FIFO vazia e parada: só então
+// o endereço de destino pode ser trocado. Um NACK no último envio por DMA
+// aparece aqui, como aborto do controlador, e tira do ar o painel que enviou.
+// Chamada do laço e do alarme de vigia, no mesmo núcleo: o painel a conferir
+// é tomado sem interrupções, para o aborto ser apurado uma vez só
+static bool ssd1306_bus_idle(i2c_inst_t *i2c) {
+  uint bus = i2c_hw_index(i2c);
+  if (bus_active[bus])
+    return false;
+  uint32_t status = i2c_get_hw(i2c)->status;
+  if (!(status & I2C_IC_STATUS_TFE_BITS) || (status & I2C_IC_STATUS_MST_ACTIVITY_BITS))
+    return false;
+  if (bus_check[bus]) {
+    uint32_t irq = save_and_disable_interrupts();
+    ssd1306_t *last = bus_check[bus];
+    bus_check[bus] = NULL;
+    if (last) {
+      i2c_bus_status_t error = i2c_bus_take_abort(i2c);
+      if (error != I2C_BUS_OK)
+        ssd1306_fault(last, error);
+    }
+    restore_interrupts(irq);
+  }
+  return true;
+}
+
+static void ssd1306_group_release(ssd1306_group_t *group);
+
+// Prazo estourado no controlador: um escravo segura o barramento e o DMA ou a
+// FIFO não andam. Aborta o DMA, descarta os envios do grupo ainda na fila
+// deste barramento (o buffer da frente deles já não corresponde ao painel),
+// libera o barramento com pulsos de SCL e tira do ar o painel que transmitia
+static void ssd1306_bus_timeout(i2c_inst_t *i2c) {
+  uint bus = i2c_hw_index(i2c);
+  uint32_t irq = save_and_disable_interrupts();
+  ssd1306_t *active = bus_active[bus];
+  ssd1306_t *culprit = active ? active : bus_check[bus];
+  uint32_t elapsed = culprit ? time_us_32() - culprit->tx_start_us : 0;
+  if (active) {
+    // Com a interrupção do canal habilitada, o aborto a dispararia (errata RP2040-E13)
+    dma_channel_set_irq1_enabled(active->dma_channel, false);
+    dma_channel_abort(active->dma_channel);
+    dma_channel_acknowledge_irq1(active->dma_channel);
+    dma_channel_set_irq1_enabled(active->dma_channel, true);
+    active->busy = false;
+    bus_active[bus] = NULL;
+    if (active->group)
+      ssd1306_group_release(active->group);
+  }
+  bus_check[bus] = NULL;
+  ssd1306_group_t *group = culprit ? culprit->group : NULL;
+  for (uint i = 0; group && i < group->n_panels; ++i) {
+    ssd1306_t *ssd = group->panels[i];
+    if (ssd->queued && ssd->i2c_port == i2c) {
+      ssd->queued = false;
+      ssd->front_valid = false;
+      ssd->stats.skipped++;
+      ssd1306_group_release(group);
+    }
+  }
+  restore_interrupts(irq);
+
+  bool released = i2c_bus_recover(i2c);
+  i2c_bus_record(i2c, I2C_BUS_TIMEOUT, elapsed);
+  if (culprit)
+    ssd1306_fault(culprit, released ? I2C_BUS_TIMEOUT : I2C_BUS_STUCK);
+}
+
+// Vigia do envio por DMA (alarme, no núcleo do display): enquanto houver
+// envio a verificar no barramento, confere a cada SSD1306_BUS_RETRY_US se o
+// controlador parou, o que também apura um NACK, até o prazo; passado ele,
+// libera o barramento. Assim quem espera por ssd1306_flush_busy nunca espera
+// mais que o prazo
+static int64_t ssd1306_bus_watch(alarm_id_t id, void *user_data) {
+  i2c_inst_t *i2c = user_data;
+  uint bus = i2c_hw_index(i2c);
+  if (bus_watch[bus] == id)
+    bus_watch[bus] = 0;
+  if ((!bus_active[bus] && !bus_check[bus]) || ssd1306_bus_idle(i2c))
+    return 0;
+  if (!ssd1306_expired(bus_deadline[bus])) {
+    bus_watch[bus] = id;
+    return -SSD1306_BUS_RETRY_US;
+  }
+  ssd1306_bus_timeout(i2c);
+  return 0;
+}
+
+static void ssd1306_bus_watch_in(i2c_inst_t *i2c, uint32_t delay_us) {
+  uint bus = i2c_hw_index(i2c);
+  uint32_t irq = save_and_disable_interrupts();
+  if (bus_watch[bus])
+    alarm_pool_cancel_alarm(ssd1306_alarm_pool(), bus_watch[bus]);
+  alarm_id_t id = alarm_pool_add_alarm_in_us(ssd1306_alarm_pool(), delay_us, ssd1306_bus_watch, i2c, true);
+  bus_watch[bus] = id > 0 ? id : 0;
+  restore_interrupts(irq);
+}
+
+// Verdadeiro se há um painel respondendo (ACK) no endereço, para detectar
+// painéis opcionais antes de ssd1306_init. O barramento já deve estar iniciado
+bool ssd1306_present(i2c_inst_t *i2c, uint8_t address) {
+  while (!ssd1306_bus_idle(i2c))
+    tight_loop_contents();
+  return ssd1306_nop(i2c, address);
+}
+
+// Verdadeiro enquanto o envio do painel estiver na fila do grupo ou em
+// andamento, ou enquanto outro painel ocupar o mesmo barramento
+bool ssd1306_flush_busy(ssd1306_t *ssd) {
+  return ssd->busy || ssd->queued || !ssd1306_bus_idle(ssd->i2c_port);
+}
+
+void ssd1306_flush_wait(ssd1306_t *ssd) {
+  while (ssd1306_flush_busy(ssd))
+    tight_loop_contents();
+}
+
+// Monta em tx_stream o envio das regiões alteradas desde o último envio e as
+// copia para o buffer da frente
+static void ssd1306_flush_prepare(ssd1306_t *ssd) {
+  uint32_t bytes = 0;
+  uint16_t windows = 0;
+  uint32_t full_cost = SSD1306_WINDOW_COST + SSD1306_DATA_COST + ssd1306_pages(ssd) * ssd1306_width(ssd);
+
+  if (ssd->front_valid)
+    ssd1306_trim_dirty(ssd);
+  else
+    ssd1306_invalidate(ssd);
+
+  // Agrupa páginas alteradas consecutivas em janelas. A página seguinte entra
+  // na janela corrente quando alargar as colunas custa menos que abrir outra.
+  uint8_t win_x0[SSD1306_MAX_PAGES], win_x1[SSD1306_MAX_PAGES];
+  uint8_t win_p0[SSD1306_MAX_PAGES], win_p1[SSD1306_MAX_PAGES];
+  uint32_t cost = 0;
+  for (uint8_t page = 0; page < ssd1306_pages(ssd); ++page) {
+    if (!ssd1306_page_dirty(ssd, page))
+      continue;
+    uint8_t x0 = ssd->dirty_x0[page], x1 = ssd->dirty_x1[page];
+    if (windows > 0 && win_p1[windows - 1] == page - 1) {
+      uint8_t n = win_p1[windows - 1] - win_p0[windows - 1] + 1;
+      uint32_t cur = win_x1[windows - 1] - win_x0[windows - 1] + 1;
+      uint8_t ux0 = x0 < win_x0[windows - 1] ? x0 : win_x0[windows - 1];
+      uint8_t ux1 = x1 > win_x1[windows - 1] ? x1 : win_x1[windows - 1];
+      uint32_t merged = (uint32_t)(n + 1) * (ux1 - ux0 + 1);
+      uint32_t separate = n * cur + (x1 - x0 + 1) + SSD1306_WINDOW_COST;
+      if (merged <= separate) {
+        cost += merged - n * cur;
+        win_x0[windows - 1] = ux0;
+        win_x1[windows - 1] = ux1;
+        win_p1[windows - 1] = page;
+        continue;
+      }
+    }
+    win_x0[windows] = x0;
+    win_x1[windows] = x1;
+    win_p0[windows] = win_p1[windows] = page;
+    cost += SSD1306_WINDOW_COST + (x1 - x0 + 1);
+    ++windows;
+  }
+
+  ssd->tx_len = 0;
+  if (windows > 0) {
+    if (cost + windows * SSD1306_DATA_COST >= full_cost) {
+      // Alterações espalhadas demais: o quadro completo sai mais barato
+      windows = 1;
+      bytes = ssd1306_stream_window(ssd, 0, ssd1306_width(ssd) - 1, 0, ssd1306_pages(ssd) - 1);
+    } else {
+      for (uint16_t w = 0; w < windows; ++w)
+        bytes += ssd1306_stream_window(ssd, win_x0[w], win_x1[w], win_p0[w], win_p1[w]);
+    }
+  }
+
+  ssd->front_valid = true;
+  ssd1306_clear_dirty(ssd);
+  ssd->stats.flushes++;
+  ssd->stats.last_bytes = bytes;
+  ssd->stats.last_windows = windows;
+  ssd->stats.total_bytes += bytes;
+}
+
+// Transmite o fluxo montado; o barramento precisa estar livre
+static void ssd1306_flush_start(ssd1306_t *ssd) {
+  ssd->queued = false;
+  if (ssd->tx_len > 0) {
+    // Mesmo procedimento de i2c_write_blocking para trocar o endereço de destino
+    i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+    uint bus = i2c_hw_index(ssd->i2c_port);
+    hw->enable = 0;
+    hw->tar = ssd->address;
+    hw->enable = 1;
+    ssd->busy = true;
+    ssd->tx_start_us = time_us_32();
+    uint32_t timeout_us = i2c_bus_timeout_us(ssd->i2c_port, ssd->tx_len);
+    bus_deadline[bus] = ssd->tx_start_us + timeout_us;
+    bus_check[bus] = ssd;
+    bus_active[bus] = ssd;
+    ssd1306_bus_watch_in(ssd->i2c_port, timeout_us);
+    dma_channel_transfer_from_buffer_now(ssd->dma_channel, ssd->tx_stream, ssd->tx_len);
+  } else if (ssd->flush_cb) {
+    ssd->flush_cb(ssd, ssd->flush_cb_arg);
+  }
+}
+
+// Inicia, sem bloquear, o envio das regiões alteradas desde o último envio.
+// Os trechos alterados são copiados para o buffer da frente e para o fluxo
+// do DMA, então o desenho do próximo quadro em ram_buffer pode começar assim
+// que a função retorna. Retorna falso, sem alterar nada, se o envio anterior
+// (ou outro painel no mesmo barramento) ainda estiver em andamento. Com o
+// painel fora do ar o envio é descartado, sem callback
+bool ssd1306_flush_async(ssd1306_t *ssd) {
+  if (ssd1306_flush_busy(ssd))
+    return false;
+  if (!ssd1306_ready(ssd)) {
+    ssd->stats.skipped++;
+    return true;
+  }
+  ssd1306_flush_prepare(ssd);
+  ssd1306_flush_start(ssd);
+  return true;
+}
+
+void ssd1306_group_init(ssd1306_group_t *group) {
+  memset(group, 0, sizeof(*group));
+}
+
+bool ssd1306_group_add(ssd1306_group_t *group, ssd1306_t *ssd) {
+  if (group->n_panels == SSD1306_MAX_PANELS)
+    return false;
+  group->panels[group->n_panels++] = ssd;
+  ssd->group = group;
+  return true;
+}
+
+void ssd1306_group_set_callback(ssd1306_group_t *group, ssd1306_group_cb_t cb, void *arg) {
+  group->cb = cb;
+  group->cb_arg = arg;
+}
+
+bool ssd1306_group_busy(ssd1306_group_t *group) {
+  // Cada painel primeiro: um prazo estourado libera o grupo
+  for (uint i = 0; i < group->n_panels; ++i) {
+    ssd1306_t *ssd = group->panels[i];
+    if (ssd->queued && ssd1306_bus_idle(ssd->i2c_port)) {
+      // Barramento livre e o painel ainda na fila: a nova tentativa não
+      // coube no pool de alarmes, então o envio começa daqui
+      uint32_t irq = save_and_disable_interrupts();
+      if (ssd->queued && !bus_active[i2c_hw_index(ssd->i2c_port)])
+        ssd1306_flush_start(ssd);
+      restore_interrupts(irq);
+    }
+    if (ssd1306_flush_busy(ssd))
+      return true;
+  }
+  return group->remaining != 0;
+}
+
+void ssd1306_group_wait(ssd1306_group_t *group) {
+  while (ssd1306_group_busy(group))
+    tight_loop_contents();
+}
+
+// Próximo painel do grupo esperando o barramento i2c
+static ssd1306_t *ssd1306_group_next(ssd1306_group_t *group, i2c_inst_t *i2c) {
+  for (uint i = 0; i < group->n_panels; ++i) {
+    ssd1306_t *ssd = group->panels[i];
+    if (ssd->queued && ssd->i2c_port == i2c)
+      return ssd;
+  }
+  return NULL;
+}
+
+// O DMA termina com os últimos bytes ainda na FIFO do controlador, que só
+// aceita outro endereço depois de esvaziá-la: tenta de novo até lá (alarme,
+// no núcleo do display)
+static int64_t ssd1306_group_retry(alarm_id_t id, void *user_data) {
+  (void)id;
+  ssd1306_t *ssd = user_data;
+  if (!ssd->queued) // Descartado por prazo estourado no barramento
+    return 0;
+  if (!ssd1306_bus_idle(ssd->i2c_port))
+    return -SSD1306_BUS_RETRY_US;
+  ssd1306_flush_start(ssd);
+  return 0;
+}
+
+// Fim do DMA de um painel do grupo (na interrupção): passa o barramento ao
+// próximo painel dele e avisa quando o último terminar
+static void ssd1306_group_done(ssd1306_t *ssd) {
+  ssd1306_group_t *group = ssd->group;
+  ssd1306_t *next = ssd1306_group_next(group, ssd->i2c_port);
+  if (next) {
+    if (ssd1306_bus_idle(next->i2c_port))
+      ssd1306_flush_start(next);
+    else
+      // Sem alarme livre, next segue na fila e ssd1306_group_busy o começa
+      alarm_pool_add_alarm_in_us(ssd1306_alarm_pool(), SSD1306_BUS_RETRY_US, ssd1306_group_retry, next, true);
+  }
+  ssd1306_group_release(group);
+}
+
+// Um painel do grupo terminou (ou foi descartado): avisa quando for o último
+static void ssd1306_group_release(ssd1306_group_t *group) {
+  if (group->remaining && --group->remaining == 0 && group->cb)
+    group->cb(group, group->cb_arg);
+}
+
+// Monta os envios de todos os painéis do grupo e começa um por barramento; os
+// outros seguem pela interrupção do DMA. Painéis sem nada a enviar chamam o
+// callback na hora, como em ssd1306_flush_async; painéis fora do ar ficam de
+// fora, até a reconfiguração deles dar certo. Retorna falso, sem alterar
+// nada, se algum painel do grupo ainda estiver transmitindo
+bool ssd1306_group_flush(ssd1306_group_t *group) {
+  if (ssd1306_group_busy(group))
+    return false;
+  uint8_t queued = 0;
+  for (uint i = 0; i < group->n_panels; ++i) {
+    ssd1306_t *ssd = group->panels[i];
+    ssd->queued = false;
+    if (!ssd1306_ready(ssd)) {
+      ssd->stats.skipped++;
+      continue;
+    }
+    ssd1306_flush_prepare(ssd);
+    ssd->queued = ssd->tx_len > 0;
+    queued += ssd->queued;
+  }
+  group->remaining = queued;
+  for (uint i = 0; i < group->n_panels; ++i) {
+    ssd1306_t *ssd = group->panels[i];
+    if (!ssd->queued && !ssd->offline && ssd->flush_cb)
+      ssd->flush_cb(ssd, ssd->flush_cb_arg);
+  }
+  if (queued == 0) {
+    if (group->cb)
+      group->cb(group, group->cb_arg);
+    return true;
+  }
+  // Sem interrupções até todos os barramentos começarem: o fim de um DMA não
+  // pode passar o barramento adiante antes de o laço terminar
+  uint32_t irq = save_and_disable_interrupts();
+  for (uint i = 0; i < group->n_panels; ++i) {
+    ssd1306_t *ssd = group->panels[i];
+    if (ssd->queued && ssd1306_bus_idle(ssd->i2c_port))
+      ssd1306_flush_start(ssd);
+  }
+  restore_interrupts(irq);
+  return true;
+}
+
+// Envia já, sem cópia e sem DMA, o retângulo (x, y, width, height) arredondado
+// para páginas inteiras e aparado às colunas que diferem do último quadro
+// enviado: uma transação de comandos programa a janela e os dados saem direto
+// de ram_buffer. Para cada página, o byte anterior ao trecho é trocado pelo
+// controle 0x40 durante a escrita e restaurado em seguida (na página 0 com a
+// janela desde a coluna 0 ele já é ram_buffer[0]). Bloqueia até o fim da
+// transmissão, esperando antes um envio por DMA em andamento; serve para regiões
+// pequenas e frequentes, em que a cópia para o fluxo do DMA e a montagem do
+// envio pesam mais que os poucos bytes de dados. Com o painel fora do ar nada
+// é enviado; logo depois da reconfiguração, o quadro inteiro vai por DMA
+void ssd1306_update_region(ssd1306_t *ssd, uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+  int x0 = x, y0 = y, x1 = x + width - 1, y1 = y + height - 1;
+  if (width == 0 || height == 0 || !ssd1306_clip(ssd, &x0, &y0, &x1, &y1))
+    return;
+  uint8_t p0 = y0 >> 3, p1 = y1 >> 3;
+  uint8_t region_x0 = x0, region_x1 = x1, region_p0 = p0, region_p1 = p1;
+
+  ssd1306_flush_wait(ssd);
+  bool reconfigured = ssd->offline;
+  if (!ssd1306_ready(ssd)) {
+    ssd->stats.skipped++;
+    return;
+  }
+  if (reconfigured) {
+    ssd1306_flush_async(ssd);
+    return;
+  }
+  if (ssd->front_valid) {
+    // Menor janela (páginas e faixa de colunas) que cobre todas as diferenças
+    int lo = x1 + 1, hi = x0 - 1;
+    int first = -1, last = -1;
+    for (uint8_t page = p0; page <= p1; ++page) {
+      const uint8_t *ram = &ssd->ram_buffer[page * ssd1306_width(ssd) + 1];
+      const uint8_t *front = &ssd->front_buffer[page * ssd1306_width(ssd) + 1];
+      int c0 = x0;
+      while (c0 <= x1 && ram[c0] == front[c0])
+        ++c0;
+      if (c0 > x1)
+        continue;
+      int c1 = x1;
+      while (ram[c1] == front[c1])
+        --c1;
+      if (c0 < lo)
+        lo = c0;
+      if (c1 > hi)
+        hi = c1;
+      if (first < 0)
+        first = page;
+      last = page;
+    }
+    x0 = lo;
+    x1 = hi;
+    if (first >= 0) {
+      p0 = first;
+      p1 = last;
+    }
+  }
+
+  uint32_t bytes = 0;
+  if (x0 <= x1) {
+    size_t span = x1 - x0 + 1;
+    uint8_t window[] = {0x00, SET_COL_ADDR, x0, x1, SET_PAGE_ADDR, p0, p1};
+    i2c_bus_status_t status = i2c_bus_write(ssd->i2c_port, ssd->address, window, sizeof(window));
+    for (uint8_t page = p0; page <= p1 && status == I2C_BUS_OK; ++page) {
+      size_t offset = page * ssd1306_width(ssd) + x0 + 1;
+      uint8_t saved = ssd->ram_buffer[offset - 1];
+      ssd->ram_buffer[offset - 1] = 0x40;
+      status = i2c_bus_write(ssd->i2c_port, ssd->address, &ssd->ram_buffer[offset - 1], span + 1);
+      ssd->ram_buffer[offset - 1] = saved;
+      memcpy(&ssd->front_buffer[offset], &ssd->ram_buffer[offset], span);
+    }
+    if (status != I2C_BUS_OK) {
+      // As páginas que faltaram seguem marcadas; o painel volta com o quadro inteiro
+      ssd1306_fault(ssd, status);
+      return;
+    }
+    bytes = SSD1306_WINDOW_COST + (p1 - p0 + 1) * (SSD1306_DATA_COST + span);
+  }
+
+  // Páginas cujo trecho alterado coube na região ficam limpas; as demais serão
+  // aparadas contra o buffer da frente no próximo envio
+  for (uint8_t page = region_p0; page <= region_p1; ++page) {
+    if (region_x0 <= ssd->dirty_x0[page] && region_x1 >= ssd->dirty_x1[page]) {
+      ssd->dirty_x0[page] = 0xFF;
+      ssd->dirty_x1[page] = 0;
+    }
+  }
+  ssd->stats.flushes++;
+  ssd->stats.last_bytes = bytes;
+  ssd->stats.last_windows = bytes ? 1 : 0;
+  ssd->stats.total_bytes += bytes;
+  if (ssd->flush_cb)
+    ssd->flush_cb(ssd, ssd->flush_cb_arg);
+}
+
+// Envia as regiões alteradas e aguarda o fim da transmissão
 void ssd1306_send_data(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_COL_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->width - 1);
-  ssd1306_command(ssd, SET_PAGE_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->pages - 1);
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->ram_buffer,
-    ssd->bufsize,
-    false
-  );
+  ssd1306_flush_wait(ssd);
+  ssd1306_flush_async(ssd);
+  ssd1306_flush_wait(ssd);
+}
+
+// Primeiro byte da página no buffer de trás
+static inline uint8_t *ssd1306_page_ptr(ssd1306_t *ssd, uint8_t page) {
+  return &ssd->ram_buffer[page * ssd1306_width(ssd) + 1];
+}
+
+// Aplica a máscara de bits aos bytes x0..x1 de uma página. Bytes inteiros são
+// preenchidos com memset; máscaras parciais são aplicadas quatro colunas por vez.
+static void ssd1306_span(ssd1306_t *ssd, uint8_t page, uint8_t x0, uint8_t x1, uint8_t mask, bool value) {
+  uint8_t *p = ssd1306_page_ptr(ssd, page) + x0;
+  uint8_t *end = ssd1306_page_ptr(ssd, page) + x1 + 1;
+  ssd1306_mark_page(ssd, page, x0, x1);
+
+  if (mask == 0xFF) {
+    memset(p, value ? 0xFF : 0x00, end - p);
+    return;
+  }
+  while (p < end && ((uintptr_t)p & 3)) {
+    *p = value ? (*p | mask) : (*p & ~mask);
+    ++p;
+  }
+  uint32_t mask32 = mask * 0x01010101u;
+  ssd1306_word_t *w = (ssd1306_word_t *)p;
+  if (value) {
+    for (; (uint8_t *)(w + 1) <= end; ++w)
+      *w |= mask32;
+  } else {
+    for (; (uint8_t *)(w + 1) <= end; ++w)
+      *w &= ~mask32;
+  }
+  for (p = (uint8_t *)w; p < end; ++p)
+    *p = value ? (*p | mask) : (*p & ~mask);
+}
+
+// Preenche o retângulo de colunas x0..x1 e linhas y0..y1 (já recortado): as
+// páginas internas recebem bytes inteiros, as das bordas recebem máscaras
+static void ssd1306_fill_area(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
+  uint8_t p0 = y0 >> 3, p1 = y1 >> 3;
+  if (p0 == p1) {
+    ssd1306_span(ssd, p0, x0, x1, mask_from[y0 & 7] & mask_to[y1 & 7], value);
+    return;
+  }
+  ssd1306_span(ssd, p0, x0, x1, mask_from[y0 & 7], value);
+  for (uint8_t page = p0 + 1; page < p1; ++page)
+    ssd1306_span(ssd, page, x0, x1, 0xFF, value);
+  ssd1306_span(ssd, p1, x0, x1, mask_to[y1 & 7], value);
 }
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
-  uint16_t index = (y >> 3) + (x << 3) + 1;
+  if (x >= ssd1306_width(ssd) || y >= ssd1306_height(ssd))
+    return;
+  uint8_t page = y >> 3;
+  uint16_t index = page * ssd1306_width(ssd) + x + 1;
   uint8_t pixel = (y & 0b111);
+  ssd1306_mark_page(ssd, page, x, x);
   if (value)
     ssd->ram_buffer[index] |= (1 << pixel);
   else
     ssd->ram_buffer[index] &= ~(1 << pixel);
 }
 
-/*
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-  uint8_t byte = value ? 0xFF : 0x00;
-  for (uint8_t i = 1; i < ssd->bufsize; ++i)
-    ssd->ram_buffer[i] = byte;
-}*/
-
 void ssd1306_fill(ssd1306_t *ssd, bool value) {
-    // Itera por todas as posições do display
-    for (uint8_t y = 0; y < ssd->height; ++y) {
-        for (uint8_t x = 0; x < ssd->width; ++x) {
-            ssd1306_pixel(ssd, x, y, value);
-        }
-    }
+  memset(&ssd->ram_buffer[1], value ? 0xFF : 0x00, ssd1306_pages(ssd) * ssd1306_width(ssd));
+  ssd1306_invalidate(ssd);
 }
 
-
+void ssd1306_fill_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value) {
+  int x0 = left, y0 = top, x1 = left + width - 1, y1 = top + height - 1;
+  if (width == 0 || height == 0 || !ssd1306_clip(ssd, &x0, &y0, &x1, &y1))
+    return;
+  ssd1306_fill_area(ssd, x0, y0, x1, y1, value);
+}
 
 void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
-  for (uint8_t x = left; x < left + width; ++x) {
-    ssd1306_pixel(ssd, x, top, value);
-    ssd1306_pixel(ssd, x, top + height - 1, value);
-  }
-  for (uint8_t y = top; y < top + height; ++y) {
-    ssd1306_pixel(ssd, left, y, value);
-    ssd1306_pixel(ssd, left + width - 1, y, value);
-  }
+  if (width == 0 || height == 0)
+    return;
+  int right = left + width - 1, bottom = top + height - 1;
 
-  if (fill) {
-    for (uint8_t x = left + 1; x < left + width - 1; ++x) {
-      for (uint8_t y = top + 1; y < top + height - 1; ++y) {
-        ssd1306_pixel(ssd, x, y, value);
-      }
-    }
-  }
+  ssd1306_hline(ssd, left, right > 255 ? 255 : right, top, value);
+  if (bottom <= 255)
+    ssd1306_hline(ssd, left, right > 255 ? 255 : right, bottom, value);
+  ssd1306_vline(ssd, left, top, bottom > 255 ? 255 : bottom, value);
+  if (right <= 255)
+    ssd1306_vline(ssd, right, top, bottom > 255 ? 255 : bottom, value);
+
+  int x0 = left + 1, y0 = top + 1, x1 = right - 1, y1 = bottom - 1;
+  if (fill && ssd1306_clip(ssd, &x0, &y0, &x1, &y1))
+    ssd1306_fill_area(ssd, x0, y0, x1, y1, value);
 }
 
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
+    // Linhas horizontais e verticais usam as rotinas por byte
+    if (y0 == y1) {
+      ssd1306_hline(ssd, x0 < x1 ? x0 : x1, x0 < x1 ? x1 : x0, y0, value);
+      return;
+    }
+    if (x0 == x1) {
+      ssd1306_vline(ssd, x0, y0 < y1 ? y0 : y1, y0 < y1 ? y1 : y0, value);
+      return;
+    }
+
     int dx = abs(x1 - x0);
     int dy = abs(y1 - y0);
 
@@ -144,56 +972,138 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
 
 
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
-  for (uint8_t x = x0; x <= x1; ++x)
-    ssd1306_pixel(ssd, x, y, value);
+  int cx0 = x0, cy0 = y, cx1 = x1, cy1 = y;
+  if (!ssd1306_clip(ssd, &cx0, &cy0, &cx1, &cy1))
+    return;
+  ssd1306_span(ssd, y >> 3, cx0, cx1, 1 << (y & 7), value);
+}
+
+void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
+  int cx0 = x, cy0 = y0, cx1 = x, cy1 = y1;
+  if (!ssd1306_clip(ssd, &cx0, &cy0, &cx1, &cy1))
+    return;
+  ssd1306_fill_area(ssd, cx0, cy0, cx1, cy1, value);
+}
+
+// Texto de ssd1306_draw_string*: a fonte 8x8 de passo fixo, sem compactação,
+// lida direto da flash
+static inline const uint8_t *ssd1306_glyph(char c) {
+  return font_glyph(&font_8x8, font_find(&font_8x8, c), NULL);
+}
+
+// Combina os bits de uma coluna do glifo com o byte da página. mask indica as
+// linhas da célula que caem nesta página e bits já vem deslocado para elas.
+static inline uint8_t ssd1306_merge(uint8_t dst, uint8_t bits, uint8_t mask, uint8_t mode) {
+  switch (mode) {
+    case SSD1306_GLYPH_TRANSPARENT:
+      return dst | bits;
+    case SSD1306_GLYPH_TRANSPARENT | SSD1306_GLYPH_INVERT:
+      return dst & ~bits;
+    case SSD1306_GLYPH_INVERT:
+      return (dst & ~mask) | (~bits & mask);
+    default:
+      return (dst & ~mask) | bits;
+  }
+}
+
+// Copia ncols colunas de 8 linhas para a posição (x, y), sem marcar regiões
+// alteradas. Com y múltiplo de 8 cada coluna é exatamente um byte de página;
+// caso contrário a coluna é dividida entre duas páginas por deslocamento.
+static void ssd1306_blit_columns(ssd1306_t *ssd, const uint8_t *cols, uint8_t ncols, uint8_t x, uint8_t y, uint8_t mode) {
+  uint8_t page = y >> 3, shift = y & 7;
+  uint8_t *lo = ssd1306_page_ptr(ssd, page) + x;
+
+  if (shift == 0) {
+    if (mode == SSD1306_GLYPH_OPAQUE) {
+      memcpy(lo, cols, ncols);
+    } else {
+      for (uint8_t i = 0; i < ncols; ++i)
+        lo[i] = ssd1306_merge(lo[i], cols[i], 0xFF, mode);
+    }
+    return;
+  }
+
+  uint8_t lo_mask = 0xFF << shift;
+  for (uint8_t i = 0; i < ncols; ++i)
+    lo[i] = ssd1306_merge(lo[i], cols[i] << shift, lo_mask, mode);
+  if (page + 1 < ssd1306_pages(ssd)) {
+    uint8_t *hi = lo + ssd1306_width(ssd);
+    uint8_t hi_mask = 0xFF >> (8 - shift);
+    for (uint8_t i = 0; i < ncols; ++i)
+      hi[i] = ssd1306_merge(hi[i], cols[i] >> (8 - shift), hi_mask, mode);
+  }
+}
+
+// Marca as páginas ocupadas por uma faixa de 8 linhas a partir de y
+static inline void ssd1306_mark_cell(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y) {
+  uint8_t page = y >> 3;
+  ssd1306_mark_page(ssd, page, x0, x1);
+  if ((y & 7) && page + 1 < ssd1306_pages(ssd))
+    ssd1306_mark_page(ssd, page + 1, x0, x1);
+}
+
+// Desenha colunas de 8 linhas (uma página de glifo de font.h) recortando às bordas do painel
+void ssd1306_blit(ssd1306_t *ssd, const uint8_t *cols, uint8_t ncols, uint8_t x, uint8_t y, uint8_t mode) {
+  if (x >= ssd1306_width(ssd) || y >= ssd1306_height(ssd) || ncols == 0)
+    return;
+  if (x + ncols > ssd1306_width(ssd))
+    ncols = ssd1306_width(ssd) - x;
+  ssd1306_blit_columns(ssd, cols, ncols, x, y, mode);
+  ssd1306_mark_cell(ssd, x, x + ncols - 1, y);
+}
+
+void ssd1306_draw_char_mode(ssd1306_t *ssd, char c, uint8_t x, uint8_t y, uint8_t mode) {
+  ssd1306_blit(ssd, ssd1306_glyph(c), 8, x, y, mode);
+}
+
+// Texto numa fonte gerada (fonts.h), sem quebra de linha: glifos de várias
+// páginas saem página a página e, nas fontes proporcionais, as colunas entre
+// glifos também são desenhadas, para que o modo opaco limpe o fundo. Retorna a
+// coluna depois do último glifo
+uint8_t ssd1306_draw_text(ssd1306_t *ssd, const font_t *font, const char *str, uint8_t x, uint8_t y, uint8_t mode) {
+  static const uint8_t gap[8] = {0};
+  uint8_t buf[FONT_MAX_GLYPH_BYTES];
+  while (*str && x < ssd1306_width(ssd)) {
+    uint8_t g = font_find(font, *str++);
+    const uint8_t *cols = font_glyph(font, g, buf);
+    uint8_t w = font->widths[g], sp = font_advance(font, g) - w;
+    for (uint8_t p = 0; p < font->pages && y + 8 * p < ssd1306_height(ssd); ++p) {
+      ssd1306_blit(ssd, cols + p * w, w, x, y + 8 * p, mode);
+      if (sp && *str && x + w < ssd1306_width(ssd))
+        ssd1306_blit(ssd, gap, sp, x + w, y + 8 * p, mode);
+    }
+    x = x + w + sp < ssd1306_width(ssd) ? x + w + sp : ssd1306_width(ssd);
+  }
+  return x;
 }
 
 // Função para desenhar um caractere no display OLED
 void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
 {
-    uint16_t index = 0;
-
-    // Determina o índice correto com base no caractere
-    if (c >= '0' && c <= '9') {
-        index = (c - '0' + 1) * 8; // Números de '0' a '9'
-    } 
-    else if (c >= 'a' && c <= 'z') {
-        index = (c - 'a' + 11) * 8; // Letras minúsculas 'a' começa no índice 11
-    } 
-    else if (c >= 'A' && c <= 'Z') {
-        index = (c - 'A' + 37) * 8; // Letras maiúsculas começam no índice 37
-    } 
-    else if (c >= '!' && c <= '/') {
-        index = (c - '!' + 63) * 8; // Letras maiúsculas começam no índice 37
-    } 
-    else {
-        index = 0; // Qualquer caractere não suportado
-    }
-
-    // Desenha o caractere no display pixel por pixel
-    for (uint8_t i = 0; i < 8; ++i) {
-        uint8_t line = font[index + i]; // Obtém a linha de pixels da fonte
-        for (uint8_t j = 0; j < 8; ++j) {
-            ssd1306_pixel(ssd, x + i, y + j, line & (1 << j));
-        }
-    }
+  ssd1306_draw_char_mode(ssd, c, x, y, SSD1306_GLYPH_OPAQUE);
 }
 
-// Função para desenhar uma string
-void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y)
+// Desenha uma string com quebra de linha automática
+void ssd1306_draw_string_mode(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y, uint8_t mode)
 {
   while (*str)
   {
-    ssd1306_draw_char(ssd, *str++, x, y);
+    ssd1306_blit(ssd, ssd1306_glyph(*str++), 8, x, y, mode);
     x += 8;
-    if (x + 8 >= ssd->width)
+    if (x + 8 >= ssd1306_width(ssd))
     {
       x = 0;
       y += 8;
     }
-    if (y + 8 >= ssd->height)
+    if (y + 8 >= ssd1306_height(ssd))
     {
       break;
     }
   }
-}
\ No newline at end of file
+}
+
+// Função para desenhar uma string
+void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y)
+{
+  ssd1306_draw_string_mode(ssd, str, x, y, SSD1306_GLYPH_OPAQUE);
+}
@@ -1,9 +1,38 @@
+#pragma once
+
 #include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "i2c_bus.h"
+#include "font.h"
 
+// Geometria fixa na compilação (opção PAINEL_OLED_GEOMETRY do CMake): todos os
+// painéis têm SSD1306_FIXED_WIDTH x SSD1306_FIXED_HEIGHT, as contas de índice
+// usam constantes e a sequência de inicialização já sai pronta da flash. Sem
+// elas, cada instância guarda a própria geometria
+#if defined(SSD1306_FIXED_WIDTH) && defined(SSD1306_FIXED_HEIGHT)
+#define WIDTH SSD1306_FIXED_WIDTH
+#define HEIGHT SSD1306_FIXED_HEIGHT
+#else
 #define WIDTH 128
 #define HEIGHT 64
+#endif
+
+#define SSD1306_MAX_PAGES 8 // Painéis de até 64 linhas
+#define SSD1306_MAX_PANELS 4 // Instâncias com transferência por DMA simultâneas
+#define SSD1306_MAX_BUSES 2  // i2c0 e i2c1
+#define SSD1306_BUS_RETRY_US 20 // Espera entre tentativas de passar o barramento ao próximo painel do grupo
+#define SSD1306_REINIT_MIN_US 50000   // Primeira reconfiguração de um painel que parou de responder
+#define SSD1306_REINIT_MAX_US 1000000 // Intervalo máximo entre reconfigurações (dobra a cada falha)
+// Alarmes simultâneos do driver: a vigia de cada barramento e a espera de cada painel do grupo
+#define SSD1306_ALARMS (SSD1306_MAX_BUSES + SSD1306_MAX_PANELS)
+
+// Palavras de IC_DATA_CMD ocupadas por uma janela (controle 0x00 + seis bytes de comando)
+#define SSD1306_WINDOW_WORDS (1 + 6)
+// Buffer de um painel: byte de controle 0x40 seguido da GDDRAM
+#define SSD1306_BUFSIZE(width, height) ((width) * ((height) / 8) + 1)
+// Fluxo do DMA no pior caso: uma janela e uma transação de dados por página, mais o quadro inteiro
+#define SSD1306_TX_WORDS(width, height) (((height) / 8) * (SSD1306_WINDOW_WORDS + 1) + (width) * ((height) / 8))
 
 typedef enum {
   SET_CONTRAST = 0x81,
@@ -25,25 +54,151 @@ typedef enum {
   SET_CHARGE_PUMP = 0x8D
 } ssd1306_command_t;
 
+// Contadores de tráfego no barramento, atualizados a cada envio
+typedef struct {
+  uint32_t flushes;      // Número de envios realizados
+  uint32_t last_bytes;   // Bytes transmitidos no último envio (endereço e controle incluídos)
+  uint32_t total_bytes;  // Bytes transmitidos desde a inicialização
+  uint16_t last_windows; // Janelas de endereçamento programadas no último envio
+  uint32_t errors;       // Transações recusadas (NACK) ou com prazo estourado
+  uint32_t reinits;      // Reconfigurações depois de o painel voltar a responder
+  uint32_t skipped;      // Envios descartados com o painel fora do ar
+} ssd1306_stats_t;
+
+// Modos de desenho de glifos (ssd1306_blit e funções *_mode), combináveis
+typedef enum {
+  SSD1306_GLYPH_OPAQUE = 0,      // A célula inteira é sobrescrita
+  SSD1306_GLYPH_TRANSPARENT = 1, // Só os pixels acesos do glifo são desenhados
+  SSD1306_GLYPH_INVERT = 2       // Cores trocadas (com TRANSPARENT, apaga os pixels do glifo)
+} ssd1306_glyph_mode_t;
+
+// Buffers de um painel em memória estática, para ssd1306_init_static.
+// Declarados com SSD1306_STORAGE(nome, largura, altura)
 typedef struct {
+  uint8_t *ram;   // SSD1306_BUFSIZE + 3 bytes, alinhado em 32 bits
+  uint8_t *front; // SSD1306_BUFSIZE bytes
+  uint16_t *tx;   // SSD1306_TX_WORDS palavras
+  uint8_t width, height;
+} ssd1306_storage_t;
+
+#define SSD1306_STORAGE(name, width, height)                                             \
+  static uint8_t name##_ram[SSD1306_BUFSIZE(width, height) + 3] __attribute__((aligned(4))); \
+  static uint8_t name##_front[SSD1306_BUFSIZE(width, height)];                          \
+  static uint16_t name##_tx[SSD1306_TX_WORDS(width, height)];                           \
+  static const ssd1306_storage_t name = {name##_ram, name##_front, name##_tx, width, height}
+
+typedef struct ssd1306 ssd1306_t;
+typedef struct ssd1306_group ssd1306_group_t;
+
+// Chamada na interrupção do DMA quando o último byte do envio foi entregue ao
+// controlador I2C (ou direto, no fim de ssd1306_update_region e de um envio vazio)
+typedef void (*ssd1306_flush_cb_t)(ssd1306_t *ssd, void *arg);
+// Chamada quando o último painel de um envio em grupo terminou
+typedef void (*ssd1306_group_cb_t)(ssd1306_group_t *group, void *arg);
+
+struct ssd1306 {
   uint8_t width, height, pages, address;
   i2c_inst_t *i2c_port;
   bool external_vcc;
-  uint8_t *ram_buffer;
-  size_t bufsize;
+  uint8_t *ram_buffer;    // Buffer de trás: onde as funções de desenho escrevem
+  uint8_t *front_buffer;  // Buffer da frente: último quadro entregue ao painel
+  bool front_valid;       // Falso enquanto o conteúdo da GDDRAM for desconhecido
+  uint16_t *tx_stream;    // Palavras de IC_DATA_CMD transmitidas pelo DMA
+  size_t tx_capacity, tx_len;
+  int dma_channel;
+  volatile bool busy;     // DMA em andamento
+  ssd1306_flush_cb_t flush_cb;
+  void *flush_cb_arg;
+  ssd1306_group_t *group; // Grupo de envio, se houver
+  volatile bool queued;   // Fluxo montado, esperando o barramento dentro do grupo
+  uint32_t tx_start_us;   // Início do envio por DMA
+  volatile bool offline;  // Parou de responder: envios descartados até a reconfiguração
+  i2c_bus_status_t last_error;
+  uint32_t retry_at_us, retry_delay_us; // Próxima reconfiguração e o intervalo atual
   uint8_t port_buffer[2];
-} ssd1306_t;
+  uint8_t dirty_x0[SSD1306_MAX_PAGES]; // Faixa de colunas alterada em cada página
+  uint8_t dirty_x1[SSD1306_MAX_PAGES]; // (dirty_x0 > dirty_x1 indica página limpa)
+  ssd1306_stats_t stats;
+};
+
+// Painéis atualizados juntos: ssd1306_group_flush monta os fluxos de todos e
+// transmite ao mesmo tempo nos dois controladores. Painéis no mesmo barramento
+// (endereços diferentes) saem em sequência, encadeados pela interrupção do DMA,
+// então o envio dura o do barramento mais carregado, não a soma
+struct ssd1306_group {
+  ssd1306_t *panels[SSD1306_MAX_PANELS];
+  uint8_t n_panels;
+  volatile uint8_t remaining; // Painéis ainda na fila ou transmitindo
+  ssd1306_group_cb_t cb;
+  void *cb_arg;
+};
+
+// Geometria de uma instância: constantes com SSD1306_FIXED_*
+static inline uint8_t ssd1306_width(const ssd1306_t *ssd) {
+#ifdef SSD1306_FIXED_WIDTH
+  (void)ssd;
+  return SSD1306_FIXED_WIDTH;
+#else
+  return ssd->width;
+#endif
+}
+
+static inline uint8_t ssd1306_height(const ssd1306_t *ssd) {
+#ifdef SSD1306_FIXED_HEIGHT
+  (void)ssd;
+  return SSD1306_FIXED_HEIGHT;
+#else
+  return ssd->height;
+#endif
+}
+
+static inline uint8_t ssd1306_pages(const ssd1306_t *ssd) {
+  return ssd1306_height(ssd) / 8;
+}
+
+// Com geometria fixa só painéis dela podem ser iniciados
+static inline bool ssd1306_supports(uint8_t width, uint8_t height) {
+#ifdef SSD1306_FIXED_HEIGHT
+  return width == SSD1306_FIXED_WIDTH && height == SSD1306_FIXED_HEIGHT;
+#else
+  (void)width;
+  return height % 8 == 0 && height / 8 <= SSD1306_MAX_PAGES;
+#endif
+}
 
 void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c);
-void ssd1306_config(ssd1306_t *ssd);
-void ssd1306_command(ssd1306_t *ssd, uint8_t command);
+void ssd1306_init_static(ssd1306_t *ssd, const ssd1306_storage_t *storage, bool external_vcc, uint8_t address,
+                         i2c_inst_t *i2c);
+bool ssd1306_config(ssd1306_t *ssd);
+bool ssd1306_command(ssd1306_t *ssd, uint8_t command);
+bool ssd1306_probe_baudrate(ssd1306_t *ssd, uint baudrate, uint fallback);
 void ssd1306_send_data(ssd1306_t *ssd);
+void ssd1306_update_region(ssd1306_t *ssd, uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+bool ssd1306_flush_async(ssd1306_t *ssd);
+bool ssd1306_flush_busy(ssd1306_t *ssd);
+void ssd1306_flush_wait(ssd1306_t *ssd);
+void ssd1306_set_flush_callback(ssd1306_t *ssd, ssd1306_flush_cb_t cb, void *arg);
+void ssd1306_set_alarm_pool(alarm_pool_t *pool);
+void ssd1306_group_init(ssd1306_group_t *group);
+bool ssd1306_group_add(ssd1306_group_t *group, ssd1306_t *ssd);
+bool ssd1306_group_flush(ssd1306_group_t *group);
+bool ssd1306_group_busy(ssd1306_group_t *group);
+void ssd1306_group_wait(ssd1306_group_t *group);
+void ssd1306_group_set_callback(ssd1306_group_t *group, ssd1306_group_cb_t cb, void *arg);
+bool ssd1306_present(i2c_inst_t *i2c, uint8_t address);
+void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+void ssd1306_invalidate(ssd1306_t *ssd);
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value);
 void ssd1306_fill(ssd1306_t *ssd, bool value);
+void ssd1306_fill_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value);
 void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill);
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value);
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value);
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value);
+void ssd1306_blit(ssd1306_t *ssd, const uint8_t *cols, uint8_t ncols, uint8_t x, uint8_t y, uint8_t mode);
 void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y);
-void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
\ No newline at end of file
+void ssd1306_draw_char_mode(ssd1306_t *ssd, char c, uint8_t x, uint8_t y, uint8_t mode);
+void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
+void ssd1306_draw_string_mode(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y, uint8_t mode);
+uint8_t ssd1306_draw_text(ssd1306_t *ssd, const font_t *font, const char *str, uint8_t x, uint8_t y, uint8_t mode);
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "telemetry.h"
+
+#if TELEMETRY_ENABLED
+
+#include "hardware/sync.h"
+
+// Histograma log-linear: valores até 7 us têm balde próprio; acima, quatro
+// baldes por oitava (erro de no máximo 25% no p99)
+#define TELEMETRY_LINEAR 8
+#define TELEMETRY_BUCKETS (TELEMETRY_LINEAR + (27 - 3) * 4)
+
+typedef struct {
+  uint32_t count, min, max;
+  uint64_t sum;
+  uint32_t buckets[TELEMETRY_BUCKETS];
+} telemetry_hist_t;
+
+// Registro empacotado: etapa nos 5 bits altos, duração nos 27 baixos
+typedef struct {
+  uint32_t records[TELEMETRY_RING_SIZE];
+  volatile uint32_t head; // Escrito só pelo núcleo dono
+  volatile uint32_t tail; // Escrito só por quem drena
+  uint32_t dropped;
+} telemetry_ring_t;
+
+static const char *const *stage_names;
+static uint n_stages;
+static telemetry_ring_t rings[NUM_CORES];
+static telemetry_hist_t hist[TELEMETRY_MAX_STAGES];
+static uint32_t dropped_reported;
+
+static uint telemetry_bucket(uint32_t us) {
+  if (us < TELEMETRY_LINEAR)
+    return us;
+  uint msb = 31 - __builtin_clz(us);
+  return TELEMETRY_LINEAR + (msb - 3) * 4 + ((us >> (msb - 2)) & 3);
+}
+
+// Maior valor que cai no balde
+static uint32_t telemetry_bucket_max(uint b) {
+  if (b < TELEMETRY_LINEAR)
+    return b;
+  uint msb = 3 + (b - TELEMETRY_LINEAR) / 4;
+  uint32_t base = (1u << msb) | (((b - TELEMETRY_LINEAR) & 3u) << (msb - 2));
+  return base + (1u << (msb - 2)) - 1;
+}
+
+void telemetry_init(const char *const *names, uint n) {
+  stage_names = names;
+  n_stages = n < TELEMETRY_MAX_STAGES ? n : TELEMETRY_MAX_STAGES;
+  for (uint i = 0; i < TELEMETRY_MAX_STAGES; ++i) {
+    hist[i] = (telemetry_hist_t){.min = UINT32_MAX};
+  }
+}
+
+// Chamada de tarefas e de interrupções, nos dois núcleos
+void telemetry_record(uint stage, uint32_t us) {
+  if (stage >= n_stages)
+    return;
+  if (us > TELEMETRY_MAX_US)
+    us = TELEMETRY_MAX_US;
+  telemetry_ring_t *r = &rings[get_core_num()];
+  uint32_t irq = save_and_disable_interrupts();
+  uint32_t head = r->head;
+  if (head - r->tail == TELEMETRY_RING_SIZE) {
+    ++r->dropped;
+  } else {
+    r->records[head & (TELEMETRY_RING_SIZE - 1)] = (stage << 27) | us;
+    __dmb();
+    r->head = head + 1;
+  }
+  restore_interrupts(irq);
+}
+
+// Move os registros das filas dos dois núcleos para os histogramas. Um só
+// consumidor (o núcleo 0, em tarefa de baixa prioridade)
+void telemetry_drain(void) {
+  for (uint core = 0; core < NUM_CORES; ++core) {
+    telemetry_ring_t *r = &rings[core];
+    uint32_t tail = r->tail, head = r->head;
+    __dmb();
+    for (; tail != head; ++tail) {
+      uint32_t rec = r->records[tail & (TELEMETRY_RING_SIZE - 1)];
+      telemetry_hist_t *h = &hist[rec >> 27];
+      uint32_t us = rec & TELEMETRY_MAX_US;
+      ++h->count;
+      h->sum += us;
+      if (us < h->min)
+        h->min = us;
+      if (us > h->max)
+        h->max = us;
+      ++h->buckets[telemetry_bucket(us)];
+    }
+    __dmb();
+    r->tail = tail;
+  }
+}
+
+static uint32_t telemetry_p99(const telemetry_hist_t *h) {
+  uint32_t target = h->count - h->count / 100; // Posição do p99, arredondada para cima
+  uint32_t seen = 0;
+  for (uint b = 0; b < TELEMETRY_BUCKETS; ++b) {
+    seen += h->buckets[b];
+    if (seen >= target) {
+      uint32_t v = telemetry_bucket_max(b);
+      return v < h->max ? v : h->max;
+    }
+  }
+  return h->max;
+}
+
+// Drena, imprime as etapas com medidas desde a última impressão e zera os histogramas
+void telemetry_print(void) {
+  telemetry_drain();
+  for (uint i = 0; i < n_stages; ++i) {
+    telemetry_hist_t *h = &hist[i];
+    if (h->count == 0)
+      continue;
+    printf("telemetria,%s,%lu,%lu,%lu,%lu,%lu\n", stage_names[i], (unsigned long)h->count,
+           (unsigned long)h->min, (unsigned long)(h->sum / h->count), (unsigned long)telemetry_p99(h),
+           (unsigned long)h->max);
+    *h = (telemetry_hist_t){.min = UINT32_MAX};
+  }
+  uint32_t dropped = rings[0].dropped + rings[1].dropped;
+  if (dropped != dropped_reported) {
+    printf("telemetria,descartes,%lu,,,,\n", (unsigned long)(dropped - dropped_reported));
+    dropped_reported = dropped;
+  }
+}
+
+#endif
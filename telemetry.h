@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+
+#define TELEMETRY_MAX_STAGES 8
+#define TELEMETRY_RING_SIZE 256 // Registros por núcleo entre duas drenagens; potência de 2
+#define TELEMETRY_MAX_US ((1u << 27) - 1) // Durações maiores são saturadas
+
+// Durações por etapa e latências, em microssegundos. Cada núcleo grava numa
+// fila própria (uma palavra por registro, com as interrupções do núcleo
+// desligadas só durante a escrita); telemetry_drain() move os registros para
+// histogramas fora do caminho crítico e telemetry_print() exporta em CSV:
+//
+//   telemetria,etapa,n,min_us,avg_us,p99_us,max_us
+//
+// Sem TELEMETRY_ENABLED as marcações somem na compilação e as funções viram
+// vazias.
+
+#if TELEMETRY_ENABLED
+
+// Mede o bloco seguinte como uma etapa. Sair do bloco com break ou return
+// descarta a medida
+#define TELEMETRY_SCOPE(stage) \
+  for (uint32_t _telemetry_t0 = time_us_32(), _telemetry_once = 1; _telemetry_once; \
+       _telemetry_once = 0, telemetry_record((stage), time_us_32() - _telemetry_t0))
+#define TELEMETRY_RECORD(stage, us) telemetry_record((stage), (us))
+
+void telemetry_init(const char *const *names, uint n_stages);
+void telemetry_record(uint stage, uint32_t us);
+void telemetry_drain(void);
+void telemetry_print(void);
+
+#else
+
+#define TELEMETRY_SCOPE(stage)
+#define TELEMETRY_RECORD(stage, us) ((void)0)
+
+static inline void telemetry_init(const char *const *names, uint n_stages) {
+  (void)names;
+  (void)n_stages;
+}
+static inline void telemetry_drain(void) {
+}
+static inline void telemetry_print(void) {
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include "trace.h"
+
+#if TRACE_ENABLED
+
+#include "hardware/sync.h"
+
+typedef struct {
+  uint32_t t_us;
+  uint8_t type;
+  uint8_t pin;    // TRACE_GPIO: pino | nível << 7
+  uint16_t x, y;  // TRACE_ADC
+} trace_record_t;
+
+// Produtores só no núcleo 0 (tarefa do joystick e interrupção dos botões)
+static trace_record_t ring[TRACE_RING_SIZE];
+static volatile uint32_t head, tail;
+static uint32_t dropped;
+static uint16_t last_x = UINT16_MAX, last_y = UINT16_MAX;
+
+static void trace_push(const trace_record_t *rec) {
+  uint32_t irq = save_and_disable_interrupts();
+  if (head - tail == TRACE_RING_SIZE) {
+    ++dropped;
+  } else {
+    ring[head & (TRACE_RING_SIZE - 1)] = *rec;
+    __dmb();
+    head = head + 1;
+  }
+  restore_interrupts(irq);
+}
+
+// Leitura dos eixos; repetições da leitura anterior não são gravadas
+void trace_adc(uint32_t t_us, uint16_t x, uint16_t y) {
+  if (x == last_x && y == last_y)
+    return;
+  last_x = x;
+  last_y = y;
+  trace_push(&(trace_record_t){.t_us = t_us, .type = TRACE_ADC, .x = x, .y = y});
+}
+
+// Borda de um botão, antes do debounce (chamada da interrupção do GPIO)
+void trace_gpio(uint32_t t_us, uint8_t pin, bool level) {
+  trace_push(&(trace_record_t){.t_us = t_us, .type = TRACE_GPIO, .pin = pin | (level << 7)});
+}
+
+uint32_t trace_dropped(void) {
+  return dropped;
+}
+
+static uint8_t *trace_varint(uint8_t *p, uint32_t v) {
+  while (v >= 0x80) {
+    *p++ = v | 0x80;
+    v >>= 7;
+  }
+  *p++ = v;
+  return p;
+}
+
+static uint8_t *trace_zigzag(uint8_t *p, int32_t v) {
+  return trace_varint(p, ((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+}
+
+static void trace_base64(const uint8_t *data, uint len, char *out) {
+  static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  for (uint i = 0; i < len; i += 3) {
+    uint32_t v = data[i] << 16 | (i + 1 < len ? data[i + 1] << 8 : 0) | (i + 2 < len ? data[i + 2] : 0);
+    *out++ = digits[v >> 18];
+    *out++ = digits[(v >> 12) & 63];
+    *out++ = i + 1 < len ? digits[(v >> 6) & 63] : '=';
+    *out++ = i + 2 < len ? digits[v & 63] : '=';
+  }
+  *out = '\0';
+}
+
+// Exporta os registros pendentes, TRACE_LINE_RECORDS por linha. Um só
+// consumidor (o núcleo 0, em tarefa de baixa prioridade). O tempo de um
+// registro pode ser anterior ao do anterior (a leitura dos eixos leva o
+// instante do bloco do ADC): a diferença vai módulo 2^32
+void trace_flush(void) {
+  // Pior caso por registro: tipo, tempo (5) e dois eixos (3 cada)
+  uint8_t bin[1 + TRACE_LINE_RECORDS * 12];
+  char text[(sizeof(bin) + 2) / 3 * 4 + 1];
+  uint32_t end = head;
+  __dmb();
+  while (tail != end) {
+    uint8_t *p = bin;
+    *p++ = TRACE_VERSION;
+    uint32_t t = 0;
+    int32_t x = 0, y = 0;
+    for (uint n = 0; n < TRACE_LINE_RECORDS && tail != end; ++n, tail = tail + 1) {
+      const trace_record_t *rec = &ring[tail & (TRACE_RING_SIZE - 1)];
+      *p++ = rec->type;
+      p = trace_varint(p, rec->t_us - t);
+      t = rec->t_us;
+      if (rec->type == TRACE_ADC) {
+        p = trace_zigzag(p, rec->x - x);
+        p = trace_zigzag(p, rec->y - y);
+        x = rec->x;
+        y = rec->y;
+      } else {
+        *p++ = rec->pin;
+      }
+    }
+    trace_base64(bin, p - bin, text);
+    printf("trace,%s\n", text);
+  }
+}
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "pico/stdlib.h"
+
+#define TRACE_RING_SIZE 128      // Registros entre duas descargas; potência de 2
+#define TRACE_LINE_RECORDS 16    // Registros por linha exportada
+#define TRACE_VERSION 1
+
+// Gravação das entradas do painel para reprodução na simulação em host
+// (painel_host --replay): leituras dos eixos do joystick (só quando mudam) e
+// bordas dos botões, com o instante de cada uma. Os registros vão para uma
+// fila com as interrupções desligadas só durante a escrita; trace_flush(),
+// fora do caminho crítico, os exporta pela saída padrão em linhas
+//
+//   trace,<base64>
+//
+// que podem ser separadas do resto da saída (CSV de telemetria) e perdidas
+// no começo da captura sem afetar as seguintes. Cada linha é independente:
+//
+//   versão (TRACE_VERSION)
+//   registros: tipo (TRACE_ADC ou TRACE_GPIO), tempo em us em varint
+//   (absoluto no primeiro da linha, diferença para o anterior nos demais) e
+//     TRACE_ADC:  X e Y brutos (0-4095) em varint zigzag, diferença para o
+//                 ADC anterior da linha (para 0 no primeiro)
+//     TRACE_GPIO: um byte, pino | nível << 7
+//
+// Sem TRACE_ENABLED as chamadas somem na compilação.
+
+enum {
+  TRACE_ADC = 1,
+  TRACE_GPIO = 2,
+};
+
+#if TRACE_ENABLED
+
+void trace_adc(uint32_t t_us, uint16_t x, uint16_t y);
+void trace_gpio(uint32_t t_us, uint8_t pin, bool level);
+void trace_flush(void);
+uint32_t trace_dropped(void);
+
+#else
+
+static inline void trace_adc(uint32_t t_us, uint16_t x, uint16_t y) {
+  (void)t_us;
+  (void)x;
+  (void)y;
+}
+static inline void trace_gpio(uint32_t t_us, uint8_t pin, bool level) {
+  (void)t_us;
+  (void)pin;
+  (void)level;
+}
+static inline void trace_flush(void) {
+}
+static inline uint32_t trace_dropped(void) {
+  return 0;
+}
+
+#endif
@@ -0,0 +1,99 @@
+#include "widgets.h"
+#include "format.h"
+
+void widget_init(widget_t *w, uint8_t x, uint8_t y, uint8_t width, uint8_t height, bool color,
+                 widget_draw_fn_t draw, const void *arg) {
+  w->x = x;
+  w->y = y;
+  w->width = width;
+  w->height = height;
+  w->color = color;
+  w->draw = draw;
+  w->arg = arg;
+  w->value = 0;
+  w->valid = false;
+  w->partial = false;
+}
+
+// Número com cache de dígitos: a caixa cobre as células e a unidade, e só é
+// limpa no primeiro desenho; depois widget_draw_number reescreve só os dígitos que mudam
+void widget_init_number(widget_t *w, uint8_t x, uint8_t y, bool color, const widget_number_t *number) {
+  const digits_font_t *d = number->cache->font;
+  uint16_t width = number->cache->cells * d->width;
+  uint8_t height = d->font->height;
+  if (number->unit) {
+    width += font_text_width(number->unit_font, number->unit);
+    if (number->unit_font->height > height)
+      height = number->unit_font->height;
+  }
+  widget_init(w, x, y, width, height, color, widget_draw_number, number);
+  w->partial = true;
+}
+
+// Limpa a caixa e redesenha se o valor mudou. As primitivas de desenho marcam
+// a região alterada; com o valor igual não há escrita no buffer nem envio.
+// Widgets parciais só têm a caixa limpa antes do primeiro desenho.
+// Retorna true se o widget foi rasterizado
+bool widget_update(ssd1306_t *ssd, widget_t *w, int32_t value) {
+  if (w->valid && w->value == value)
+    return false;
+  if (!w->valid || !w->partial)
+    ssd1306_fill_rect(ssd, w->y, w->x, w->width, w->height, !w->color);
+  w->draw(ssd, w, value);
+  w->value = value;
+  w->valid = true;
+  return true;
+}
+
+// Força o próximo widget_update a redesenhar (buffer sobrescrito por fora)
+void widget_invalidate(widget_t *w) {
+  w->valid = false;
+}
+
+// Envia só a caixa do widget, direto do buffer (ssd1306_update_region)
+void widget_flush(ssd1306_t *ssd, const widget_t *w) {
+  ssd1306_update_region(ssd, w->x, w->y, w->width, w->height);
+}
+
+// Moldura na borda da caixa; o valor é ignorado
+void widget_draw_frame(ssd1306_t *ssd, const widget_t *w, int32_t value) {
+  (void)value;
+  ssd1306_rect(ssd, w->y, w->x, w->width, w->height, w->color, false);
+}
+
+// Texto fixo (arg) mostrado quando o valor é diferente de zero
+void widget_draw_label(ssd1306_t *ssd, const widget_t *w, int32_t value) {
+  if (value)
+    ssd1306_draw_string(ssd, w->arg, w->x, w->y);
+}
+
+// Um texto por valor: arg é um vetor de strings indexado pelo valor, NULL para nada
+void widget_draw_labels(ssd1306_t *ssd, const widget_t *w, int32_t value) {
+  const char *const *labels = w->arg;
+  if (value >= 0 && labels[value])
+    ssd1306_draw_string(ssd, labels[value], w->x, w->y);
+}
+
+// Número de widget_init_number (widget_number_t em arg). Negativos deixam a
+// caixa vazia; a unidade só é desenhada quando as células foram limpas
+void widget_draw_number(ssd1306_t *ssd, const widget_t *w, int32_t value) {
+  const widget_number_t *n = w->arg;
+  digits_cache_t *cache = n->cache;
+  uint8_t mode = w->color ? SSD1306_GLYPH_OPAQUE : SSD1306_GLYPH_INVERT;
+  if (!w->valid)
+    digits_cache_invalidate(cache); // widget_update acabou de limpar a caixa
+  if (value < 0) {
+    if (digits_cache_valid(cache)) {
+      ssd1306_fill_rect(ssd, w->y, w->x, w->width, w->height, !w->color);
+      digits_cache_invalidate(cache);
+    }
+    return;
+  }
+
+  bool unit = n->unit && !digits_cache_valid(cache);
+  char text[FORMAT_UINT_MAX + 1];
+  format_uint(text, value, cache->cells, ' ');
+  uint8_t x = digits_cache_draw(cache, ssd, text, w->x, w->y, mode);
+  if (unit)
+    ssd1306_draw_text(ssd, n->unit_font, n->unit, x, w->y + cache->font->font->height - n->unit_font->height, mode);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ssd1306.h"
+#include "digits.h"
+
+typedef struct widget widget_t;
+
+// Desenha o valor dentro da caixa do widget; a caixa já vem limpa com a cor de fundo
+typedef void (*widget_draw_fn_t)(ssd1306_t *ssd, const widget_t *w, int32_t value);
+
+// Elemento retido do painel: dono de uma caixa no buffer e de um valor. Só é
+// rasterizado de novo quando o valor muda, e só a sua caixa fica marcada como
+// alterada para o próximo envio.
+struct widget {
+  uint8_t x, y, width, height;
+  bool color;            // Cor dos pixels acesos; o fundo é a oposta
+  widget_draw_fn_t draw;
+  const void *arg;       // Dado fixo do desenho (texto, tabela de rótulos)
+  int32_t value;         // Último valor desenhado
+  bool valid;            // Falso até o primeiro desenho ou após widget_invalidate
+  bool partial;          // draw atualiza a caixa sozinho; ela só é limpa antes do primeiro desenho
+};
+
+// Argumento de widget_draw_number: número alinhado à direita nas células de
+// cache e, se unit não for NULL, a unidade logo depois em unit_font, alinhada
+// pela base. Cada widget precisa do próprio cache
+typedef struct {
+  digits_cache_t *cache;
+  const font_t *unit_font;
+  const char *unit;
+} widget_number_t;
+
+void widget_init(widget_t *w, uint8_t x, uint8_t y, uint8_t width, uint8_t height, bool color,
+                 widget_draw_fn_t draw, const void *arg);
+void widget_init_number(widget_t *w, uint8_t x, uint8_t y, bool color, const widget_number_t *number);
+bool widget_update(ssd1306_t *ssd, widget_t *w, int32_t value);
+void widget_invalidate(widget_t *w);
+void widget_flush(ssd1306_t *ssd, const widget_t *w);
+
+// Desenhos prontos
+void widget_draw_frame(ssd1306_t *ssd, const widget_t *w, int32_t value);
+void widget_draw_label(ssd1306_t *ssd, const widget_t *w, int32_t value);
+void widget_draw_labels(ssd1306_t *ssd, const widget_t *w, int32_t value);
+void widget_draw_number(ssd1306_t *ssd, const widget_t *w, int32_t value);